@@ -64,10 +64,11 @@ Item {
             y: Theme.paddingMedium
 
             Thumbnail {
-                visible: largeThumbnail.length > 0 && largeThumbnail !== "loading"
+                visible: largeThumbnail.length > 0
                 width: parent.width
                 height: artworkSize && artworkSize.width > artworkSize.height ? artworkSize.height / (artworkSize.width / width) : 400
                 artworkSource: largeThumbnail
+                placeholderColor: previewColor
                 fillMode: Image.PreserveAspectFit
             }
 
@@ -29,6 +29,7 @@ Loader {
 
     property string artworkSource
     property string defaultText
+    property color placeholderColor: "transparent"
     property string testColor: "green"
     property int fillMode: Image.Stretch
     property bool smooth: false
@@ -43,6 +44,12 @@ Loader {
             sourceSize.width: parent.fillMode === Image.Stretch ? width : undefined
             fillMode: Image.PreserveAspectFit
             smooth: parent.smooth
+
+            Rectangle {
+                anchors.fill: parent
+                color: placeholderColor
+                visible: parent.status !== Image.Ready
+            }
         }
     }
 
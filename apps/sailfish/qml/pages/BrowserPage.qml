@@ -105,6 +105,48 @@ Page {
             property bool useThumbnails: settings.useThumbnails
             property int itemHeight: browserPage.model && browserPage.model.thumbnailFormat === KodiModel.ThumbnailFormatPortrait ? 122 : 88
 
+            onMovementEnded: {
+                // Artwork for rows that are gone (including the cache buffer) isn't needed anymore
+                var firstCached = indexAt(0, Math.max(0, contentY - cacheBuffer));
+                var lastCached = indexAt(0, contentY + height + cacheBuffer - 1);
+                if (firstCached >= 0) {
+                    if (lastCached < 0) {
+                        lastCached = count - 1;
+                    }
+                    var cachedRows = [];
+                    for (var cachedRow = firstCached; cachedRow <= lastCached; ++cachedRow) {
+                        cachedRows.push(filterModel.mapToSourceIndex(cachedRow));
+                    }
+                    browserPage.model.setVisibleRows(cachedRows);
+                }
+
+                if (!browserPage.model.hasDetails()) {
+                    return;
+                }
+                // Get the details for everything on screen in one go so opening one of them is instant
+                var first = indexAt(0, contentY);
+                var last = indexAt(0, contentY + height - 1);
+                if (first < 0) {
+                    return;
+                }
+                if (last < 0) {
+                    last = count - 1;
+                }
+                // With a filter the rows on screen are scattered over the source model.
+                // Prefetch them in contiguous runs, not everything in between.
+                var runStart = filterModel.mapToSourceIndex(first);
+                var runEnd = runStart;
+                for (var i = first + 1; i <= last; ++i) {
+                    var row = filterModel.mapToSourceIndex(i);
+                    if (row !== runEnd + 1) {
+                        browserPage.model.prefetchItemDetails(runStart, runEnd);
+                        runStart = row;
+                    }
+                    runEnd = row;
+                }
+                browserPage.model.prefetchItemDetails(runStart, runEnd);
+            }
+
             delegate: Drawer {
                 id: drawer
 
@@ -199,6 +241,7 @@ Page {
                         visible: listView.useThumbnails && browserPage.model.thumbnailFormat !== KodiModel.ThumbnailFormatNone
 
                         artworkSource: thumbnail
+                        placeholderColor: previewColor
                         defaultText: title
 
                         IconButton {
@@ -53,6 +53,11 @@ Dialog {
                 text: qsTr("Use Thumbnails")
                 checked: settings.useThumbnails
             }
+            TextSwitch {
+                id: artworkWarmup
+                text: qsTr("Preload thumbnails on WLAN")
+                checked: settings.artworkWarmup
+            }
             /*TextSwitch {
                 id: keepDisplayLit
                 text: qsTr("Keep display on when charging")
@@ -152,6 +157,7 @@ Dialog {
         settings.pauseMusicOnCall = pauseMusic.checked
         settings.pauseVideoOnCall = pauseVideo.checked
         settings.useThumbnails = useThumbnails.checked
+        settings.artworkWarmup = artworkWarmup.checked
         settings.showCallNotifications = showNotifications.checked
         settings.musicEnabled = musicEnabled.checked
         settings.videosEnabled = videosEnabled.checked
@@ -32,6 +32,7 @@
 #include "libkodimote/eventclient.h"
 #include "libkodimote/settings.h"
 #include "libkodimote/networkaccessmanagerfactory.h"
+#include "libkodimote/imageprovider.h"
 #include "sailfishhelper.h"
 
 #include <sailfishapp.h>
@@ -70,6 +71,7 @@ int main(int argc, char *argv[])
 
     QQuickView *view = SailfishApp::createView();
     view->engine()->setNetworkAccessManagerFactory(new NetworkAccessManagerFactory());
+    view->engine()->addImageProvider("kodi", new KodiImageProvider());
     view->engine()->rootContext()->setContextProperty("kodi", Kodi::instance());
     view->engine()->rootContext()->setContextProperty("settings", &settings);
     view->setSource(SailfishApp::pathTo("qml/main.qml"));
@@ -22,6 +22,7 @@
 #include "libkodimote/settings.h"
 #include "libkodimote/eventclient.h"
 #include "libkodimote/networkaccessmanagerfactory.h"
+#include "libkodimote/imageprovider.h"
 
 #include "ubuntuhelper.h"
 
@@ -68,6 +69,7 @@ int main(int argc, char** argv)
     view->setResizeMode(QQuickView::SizeRootObjectToView);
 
     view->engine()->setNetworkAccessManagerFactory(new NetworkAccessManagerFactory());
+    view->engine()->addImageProvider("kodi", new KodiImageProvider());
 
     view->setTitle("Kodimote");
     view->engine()->rootContext()->setContextProperty("kodi", Kodi::instance());
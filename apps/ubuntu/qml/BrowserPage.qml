@@ -292,7 +292,7 @@ KodiPage {
                             anchors.centerIn: parent
                             image: Image {
                                 anchors.fill: parent
-                                source: thumbnail ? "file://" + thumbnail : ""
+                                source: thumbnail
                                 fillMode: Image.PreserveAspectCrop
                                 sourceSize {
                                     width: thumbnailImage.width
@@ -41,19 +41,7 @@ Item {
 
     property string __source
 
-    Component.onCompleted: {
-        if (source == "loading") {
-            state = "loading";
-        }
-    }
-
     onSourceChanged: {
-        if (source == "loading") {
-            image.source = "";
-            state = "loading";
-            return;
-        }
-
         if (state === "ready") {
             state = "default";
             image.nextSource = source;
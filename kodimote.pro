@@ -2,3 +2,8 @@ TEMPLATE = subdirs
 CONFIG = ordered
 
 SUBDIRS += libkodimote apps
+
+# Benchmarks aren't part of the packages, build them with "qmake CONFIG+=tests"
+tests {
+    SUBDIRS += tests
+}
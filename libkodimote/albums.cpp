@@ -27,13 +27,17 @@
 #include "audioplayer.h"
 #include "playlist.h"
 #include "libraryitem.h"
-#include "kodidownload.h"
+#include "kodidownloadjob.h"
 
 Albums::Albums(int artistId, int genreId, KodiModel *parent) :
     KodiLibrary(parent),
     m_artistId(artistId),
     m_genreId(genreId)
 {
+    // Recently added/played lists change all the time, don't cache them
+    if (artistId >= ItemIdInvalid && genreId >= ItemIdInvalid) {
+        setCacheKey(cacheKey(artistId, genreId));
+    }
 }
 
 Albums::~Albums()
@@ -110,11 +114,8 @@ void Albums::fetchItemDetails(int index)
 void Albums::download(int index, const QString &path)
 {
     qDebug() << "Downloading album";
-    m_downloadPath = path;
-    Songs *downloadModel = new Songs(m_artistId, m_list.at(index)->data(RoleAlbumId).toInt());
-    downloadModel->setDeleteAfterDownload(true);
-    m_downloadList.append(downloadModel);
-    connect(downloadModel, SIGNAL(busyChanged()), SLOT(downloadModelFilled()));
+    KodiDownloadJob *job = new KodiDownloadJob(path, m_list.at(index)->data(RoleTitle).toString());
+    job->downloadAlbum(m_list.at(index)->data(RoleAlbumId).toInt());
 }
 
 void Albums::listReceived(const QVariantMap &rsp)
@@ -158,23 +159,14 @@ void Albums::detailsReceived(const QVariantMap &rsp)
     emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
 }
 
-void Albums::downloadModelFilled()
-{
-    Songs *downloadModel = qobject_cast<Songs*>(sender());
-    qDebug() << "starting batch download of album";
-    for(int i = 0; i < downloadModel->rowCount(); ++i) {
-        downloadModel->download(i, m_downloadPath);
-    }
-
-    m_downloadList.removeAll(downloadModel);
-    if(deleteAfterDownload() && m_downloadList.isEmpty()) {
-        deleteLater();
-    }
-}
-
 KodiModel* Albums::enterItem(int index)
 {
-    return new Songs(m_artistId, m_list.at(index)->data(RoleAlbumId).toInt(), this);
+    int albumId = m_list.at(index)->data(RoleAlbumId).toInt();
+    KodiModel *model = cachedModel(Songs::cacheKey(m_artistId, albumId));
+    if (!model) {
+        model = new Songs(m_artistId, albumId, this);
+    }
+    return model;
 }
 
 void Albums::playItem(int index)
@@ -25,13 +25,12 @@
 
 #include <QStandardItem>
 
-class Songs;
-
 class Albums : public KodiLibrary
 {
     Q_OBJECT
 public:
     explicit Albums(int artistId = -1, int genreId = -1, KodiModel *parent = 0);
+    static QString cacheKey(int artistId, int genreId) { return QString("Albums/%1/%2").arg(artistId).arg(genreId); }
     ~Albums();
 
     KodiModel* enterItem(int index);
@@ -52,15 +51,11 @@ private slots:
     void listReceived(const QVariantMap &rsp);
     void detailsReceived(const QVariantMap &rsp);
 
-    void downloadModelFilled();
-
 private:
     QMap<int, int> m_detailsRequestMap;
 
     int m_artistId;
     int m_genreId;
-    QList<Songs*> m_downloadList;
-    QString m_downloadPath;
 };
 
 #endif // ALBUMS_H
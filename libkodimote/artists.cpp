@@ -26,11 +26,13 @@
 #include "audioplayer.h"
 #include "playlist.h"
 #include "libraryitem.h"
+#include "kodidownloadjob.h"
 
 Artists::Artists(int genreId, KodiModel *parent) :
     KodiLibrary(parent),
     m_genreId(genreId)
 {
+    setCacheKey(cacheKey(genreId));
 }
 
 void Artists::refresh()
@@ -88,10 +90,8 @@ void Artists::fetchItemDetails(int index)
 void Artists::download(int index, const QString &path)
 {
     qDebug() << "Downloading artist";
-    m_downloadPath = path;
-    Albums *downloadModel = new Albums(m_list.at(index)->data(RoleArtistId).toInt());
-    downloadModel->setDeleteAfterDownload(true);
-    connect(downloadModel, SIGNAL(busyChanged()), SLOT(downloadModelFilled()));
+    KodiDownloadJob *job = new KodiDownloadJob(path, m_list.at(index)->data(RoleTitle).toString());
+    job->downloadArtist(m_list.at(index)->data(RoleArtistId).toInt());
 }
 
 void Artists::listReceived(const QVariantMap &rsp)
@@ -137,21 +137,14 @@ void Artists::detailsReceived(const QVariantMap &rsp)
     emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
 }
 
-void Artists::downloadModelFilled()
-{
-    Albums *albums = qobject_cast<Albums*>(sender());
-    qDebug() << "starting batch download of artist";
-    for(int i = 0; i < albums->rowCount(); ++i) {
-        albums->download(i, m_downloadPath);
-    }
-    if(deleteAfterDownload()) {
-        deleteLater();
-    }
-}
-
 KodiModel *Artists::enterItem(int index)
 {
-    return new Albums(m_list.at(index)->data(RoleArtistId).toInt(), m_genreId, this);
+    int artistId = m_list.at(index)->data(RoleArtistId).toInt();
+    KodiModel *model = cachedModel(Albums::cacheKey(artistId, m_genreId));
+    if (!model) {
+        model = new Albums(artistId, m_genreId, this);
+    }
+    return model;
 }
 
 void Artists::playItem(int index)
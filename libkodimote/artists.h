@@ -25,13 +25,12 @@
 
 #include <QStandardItem>
 
-class Albums;
-
 class Artists : public KodiLibrary
 {
     Q_OBJECT
 public:
     explicit Artists(int genreId = -1, KodiModel *parent = 0);
+    static QString cacheKey(int genreId) { return QString("Artists/%1").arg(genreId); }
     ~Artists();
 
     KodiModel *enterItem(int index);
@@ -52,13 +51,9 @@ private slots:
     void listReceived(const QVariantMap &rsp);
     void detailsReceived(const QVariantMap &rsp);
 
-    void downloadModelFilled();
-
 private:
     int m_genreId;
     QMap<int, int> m_detailsRequestMap;
-
-    QString m_downloadPath;
 };
 
 #endif // ARTISTS_H
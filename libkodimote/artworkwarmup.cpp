@@ -0,0 +1,323 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "artworkwarmup.h"
+#include "kodi.h"
+#include "kodiconnection.h"
+#include "imagecache.h"
+#include "settings.h"
+
+#include <QDebug>
+
+// Items per list request. Keeps the command queue free for the UI in between.
+static const int listPageSize = 200;
+// Cache lookups per event loop iteration when skipping over images we already have
+static const int lookupsPerIteration = 50;
+// Pause between list requests. Large libraries would otherwise keep Kodi busy for a while.
+static const int listRequestInterval = 1000;
+
+KodiArtworkWarmup::KodiArtworkWarmup(QObject *parent) :
+    QObject(parent),
+    m_sourceIndex(0),
+    m_listOffset(0),
+    m_total(0),
+    m_done(0),
+    m_jobId(-1),
+    m_running(false),
+    m_paused(false),
+    m_enabled(Settings().artworkWarmup())
+{
+    // Don't compete with the initial burst of requests after connecting
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(30000);
+    connect(&m_idleTimer, SIGNAL(timeout()), SLOT(start()));
+
+    m_fetchTimer.setSingleShot(true);
+    connect(&m_fetchTimer, SIGNAL(timeout()), SLOT(fetchNext()));
+
+    m_listTimer.setSingleShot(true);
+    m_listTimer.setInterval(listRequestInterval);
+    connect(&m_listTimer, SIGNAL(timeout()), SLOT(requestList()));
+
+    connect(KodiConnection::notifier(), SIGNAL(connectionChanged()), SLOT(connectionChanged()));
+}
+
+bool KodiArtworkWarmup::running() const
+{
+    return m_running;
+}
+
+bool KodiArtworkWarmup::paused() const
+{
+    return m_paused;
+}
+
+int KodiArtworkWarmup::total() const
+{
+    return m_total;
+}
+
+int KodiArtworkWarmup::done() const
+{
+    return m_done;
+}
+
+qreal KodiArtworkWarmup::progress() const
+{
+    return m_total > 0 ? (qreal)m_done / m_total : 0;
+}
+
+void KodiArtworkWarmup::connectionChanged()
+{
+    stop();
+    if (KodiConnection::connected() && m_enabled) {
+        m_idleTimer.start();
+    }
+}
+
+void KodiArtworkWarmup::start()
+{
+    m_idleTimer.stop();
+    if (m_running || !KodiConnection::connected()) {
+        return;
+    }
+
+    Settings settings;
+    m_sources.clear();
+    if (settings.musicEnabled()) {
+        m_sources.append(Source("AudioLibrary.GetArtists", "artists", "thumbnail"));
+        m_sources.append(Source("AudioLibrary.GetAlbums", "albums", "thumbnail"));
+    }
+    if (settings.videosEnabled()) {
+        m_sources.append(Source("VideoLibrary.GetMovies", "movies", "thumbnail"));
+        m_sources.append(Source("VideoLibrary.GetTVShows", "tvshows", "fanart"));
+    }
+
+    m_sourceIndex = 0;
+    m_listOffset = 0;
+    m_images.clear();
+    m_seenImages.clear();
+    m_total = 0;
+    m_done = 0;
+    m_running = true;
+    emit runningChanged();
+    emit progressChanged();
+
+    requestList();
+}
+
+void KodiArtworkWarmup::stop()
+{
+    m_idleTimer.stop();
+    m_fetchTimer.stop();
+    m_listTimer.stop();
+    if (m_jobId >= 0) {
+        Kodi::instance()->imageCache()->cancel(m_jobId, this);
+        disconnect(Kodi::instance()->imageCache(), SIGNAL(fetchFailed(int)), this, SLOT(fetchFailed(int)));
+        m_jobId = -1;
+    }
+    m_images.clear();
+    m_seenImages.clear();
+    if (m_paused) {
+        m_paused = false;
+        emit pausedChanged();
+    }
+    if (m_running) {
+        m_running = false;
+        emit runningChanged();
+    }
+}
+
+void KodiArtworkWarmup::pause()
+{
+    if (!m_running || m_paused) {
+        return;
+    }
+    // Whatever is in flight finishes, nothing new gets started
+    m_paused = true;
+    m_fetchTimer.stop();
+    emit pausedChanged();
+}
+
+void KodiArtworkWarmup::resume()
+{
+    if (!m_paused) {
+        return;
+    }
+    m_paused = false;
+    emit pausedChanged();
+    fetchNext();
+}
+
+void KodiArtworkWarmup::requestList()
+{
+    if (!m_running || m_sourceIndex >= m_sources.count()) {
+        return;
+    }
+    const Source &source = m_sources.at(m_sourceIndex);
+
+    QVariantMap params;
+    QVariantList properties;
+    properties.append(source.property());
+    params.insert("properties", properties);
+
+    QVariantMap limits;
+    limits.insert("start", m_listOffset);
+    limits.insert("end", m_listOffset + listPageSize);
+    params.insert("limits", limits);
+
+    KodiConnection::sendCommand(source.method(), params, this, "listReceived");
+}
+
+void KodiArtworkWarmup::listReceived(const QVariantMap &rsp)
+{
+    if (!m_running || m_sourceIndex >= m_sources.count()) {
+        return;
+    }
+    const Source &source = m_sources.at(m_sourceIndex);
+    QVariantMap result = rsp.value("result").toMap();
+
+    foreach (const QVariant &itemVariant, result.value(source.resultKey()).toList()) {
+        QString image = itemVariant.toMap().value(source.property()).toString();
+        if (!image.isEmpty() && !m_seenImages.contains(image)) {
+            m_seenImages.insert(image);
+            m_images.append(image);
+            m_total++;
+        }
+    }
+    emit progressChanged();
+
+    m_listOffset += listPageSize;
+    if (m_listOffset >= result.value("limits").toMap().value("total").toInt()) {
+        m_sourceIndex++;
+        m_listOffset = 0;
+    }
+    if (m_sourceIndex < m_sources.count()) {
+        m_listTimer.start();
+    }
+
+    if (m_jobId < 0 && !m_fetchTimer.isActive()) {
+        fetchNext();
+    }
+}
+
+void KodiArtworkWarmup::fetchNext()
+{
+    if (!m_running || m_paused || m_jobId >= 0) {
+        return;
+    }
+
+    KodiImageCache *imageCache = Kodi::instance()->imageCache();
+    if (!onUnmeteredNetwork()) {
+        m_fetchTimer.start(60000);
+        return;
+    }
+    if (imageCache->queueLength() > 0) {
+        // The user is browsing. Their artwork comes first.
+        m_fetchTimer.start(2000);
+        return;
+    }
+
+    int lookups = 0;
+    while (!m_images.isEmpty()) {
+        if (++lookups > lookupsPerIteration) {
+            emit progressChanged();
+            m_fetchTimer.start(0);
+            return;
+        }
+
+        QString image = m_images.takeFirst();
+        QString cachedFile;
+        if (imageCache->contains(image, KodiImageCache::CacheSmall, cachedFile)) {
+            m_done++;
+            continue;
+        }
+
+        // Queued: a fetch can fail right away, before we know its id
+        connect(imageCache, SIGNAL(fetchFailed(int)), this, SLOT(fetchFailed(int)), (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
+        m_jobId = imageCache->fetch(image, this, "imageFetched", KodiImageCache::cacheSize(KodiImageCache::CacheSmall), KodiImageCache::CacheSmall);
+        emit progressChanged();
+        return;
+    }
+    emit progressChanged();
+
+    if (m_sourceIndex >= m_sources.count()) {
+        finish();
+    }
+}
+
+bool KodiArtworkWarmup::enabled() const
+{
+    return m_enabled;
+}
+
+void KodiArtworkWarmup::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    if (!enabled) {
+        stop();
+    } else if (KodiConnection::connected() && !m_running) {
+        m_idleTimer.start();
+    }
+}
+
+void KodiArtworkWarmup::imageFetched(int id)
+{
+    if (id != m_jobId) {
+        return;
+    }
+    m_jobId = -1;
+    m_done++;
+    emit progressChanged();
+    // Leave some room on the wire for everything else
+    m_fetchTimer.start(200);
+}
+
+void KodiArtworkWarmup::fetchFailed(int id)
+{
+    imageFetched(id);
+}
+
+void KodiArtworkWarmup::finish()
+{
+    qDebug() << "artwork warm-up finished:" << m_done << "images";
+    disconnect(Kodi::instance()->imageCache(), SIGNAL(fetchFailed(int)), this, SLOT(fetchFailed(int)));
+    m_seenImages.clear();
+    m_running = false;
+    emit runningChanged();
+}
+
+bool KodiArtworkWarmup::onUnmeteredNetwork() const
+{
+    QList<QNetworkConfiguration> activeConfigurations = m_networkConfigurationManager.allConfigurations(QNetworkConfiguration::Active);
+    if (activeConfigurations.isEmpty()) {
+        // No bearer information on this platform. Assume the best.
+        return true;
+    }
+    foreach (const QNetworkConfiguration &configuration, activeConfigurations) {
+        if (configuration.bearerName() == "WLAN" || configuration.bearerName() == "Ethernet") {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef ARTWORKWARMUP_H
+#define ARTWORKWARMUP_H
+
+#include <QObject>
+#include <QStringList>
+#include <QSet>
+#include <QTimer>
+#include <QVariantMap>
+#include <QNetworkConfigurationManager>
+
+/**
+  * Fills the small thumbnail cache for the whole library in the background
+  * Walks the artist, album, movie and tv show lists and fetches whatever artwork isn't cached yet.
+  * It only ever has one image in flight, only on wifi or ethernet, and backs off as soon as the
+  * user's own browsing queues up artwork in the image cache.
+  */
+class KodiArtworkWarmup : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    Q_PROPERTY(bool paused READ paused NOTIFY pausedChanged)
+    Q_PROPERTY(int total READ total NOTIFY progressChanged)
+    Q_PROPERTY(int done READ done NOTIFY progressChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+
+public:
+    explicit KodiArtworkWarmup(QObject *parent = 0);
+
+    bool running() const;
+    bool paused() const;
+    int total() const;
+    int done() const;
+    qreal progress() const;
+
+    Q_INVOKABLE void imageFetched(int id);
+
+    // Follows the ArtworkWarmup setting. Switching it off stops a running warm-up.
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+public slots:
+    void start();
+    void stop();
+    void pause();
+    void resume();
+
+signals:
+    void runningChanged();
+    void pausedChanged();
+    void progressChanged();
+
+private slots:
+    void connectionChanged();
+    void listReceived(const QVariantMap &rsp);
+    void fetchFailed(int id);
+    void fetchNext();
+    void requestList();
+
+private:
+    void finish();
+    bool onUnmeteredNetwork() const;
+
+    class Source
+    {
+    public:
+        Source(const QString &method, const QString &resultKey, const QString &property) :
+            m_method(method), m_resultKey(resultKey), m_property(property) {}
+        QString method() const { return m_method; }
+        QString resultKey() const { return m_resultKey; }
+        QString property() const { return m_property; }
+    private:
+        QString m_method;
+        QString m_resultKey;
+        QString m_property;
+    };
+
+    QList<Source> m_sources;
+    int m_sourceIndex;
+    int m_listOffset;
+
+    QStringList m_images;
+    QSet<QString> m_seenImages;
+    int m_total;
+    int m_done;
+
+    int m_jobId;
+    bool m_running;
+    bool m_paused;
+    bool m_enabled;
+
+    QTimer m_idleTimer;
+    QTimer m_fetchTimer;
+    QTimer m_listTimer;
+    QNetworkConfigurationManager m_networkConfigurationManager;
+};
+
+#endif // ARTWORKWARMUP_H
@@ -77,14 +77,22 @@ AudioLibrary::AudioLibrary() :
 KodiModel *AudioLibrary::enterItem(int index)
 {
     switch(index) {
-    case 0:
-        return new Artists(-1, this);
-    case 1:
-        return new Albums(-1, -1, this);
-    case 2:
-        return new Songs(-1, -1, this);
-    case 3:
-        return new Genres(this);
+    case 0: {
+        KodiModel *model = cachedModel(Artists::cacheKey(-1));
+        return model ? model : new Artists(-1, this);
+    }
+    case 1: {
+        KodiModel *model = cachedModel(Albums::cacheKey(-1, -1));
+        return model ? model : new Albums(-1, -1, this);
+    }
+    case 2: {
+        KodiModel *model = cachedModel(Songs::cacheKey(-1, -1));
+        return model ? model : new Songs(-1, -1, this);
+    }
+    case 3: {
+        KodiModel *model = cachedModel(Genres::cacheKey());
+        return model ? model : new Genres(this);
+    }
     case 4:
         return new RecentItems(RecentItems::ModeAudio, RecentItems::RecentlyAdded, this);
     case 5:
@@ -39,20 +39,74 @@ int AudioPlaylist::rowCount(const QModelIndex &parent) const
     return m_itemList.count();
 }
 
-void AudioPlaylist::refresh()
+QVariantList AudioPlaylist::itemProperties() const
 {
-    koDebug(XDAREA_PLAYLIST) << "Refreshing playlist" << playlistId();
-    QVariantMap params;
     QVariantList properties;
     properties.append("duration");
     properties.append("artist");
     properties.append("album");
     properties.append("thumbnail");
-    params.insert("properties", properties);
+    return properties;
+}
 
-    params.insert("playlistid", playlistId());
+void AudioPlaylist::insertItems(int position, int count)
+{
+    beginInsertRows(QModelIndex(), position, position + count - 1);
+    for(int i = 0; i < count; ++i) {
+        m_itemList.insert(position, 0);
+    }
+    endInsertRows();
+}
+
+void AudioPlaylist::removeItems(int position, int count)
+{
+    beginRemoveRows(QModelIndex(), position, position + count - 1);
+    for(int i = 0; i < count; ++i) {
+        delete m_itemList.takeAt(position);
+    }
+    endRemoveRows();
+}
+
+void AudioPlaylist::clearItems()
+{
+    beginResetModel();
+    qDeleteAll(m_itemList);
+    m_itemList.clear();
+    endResetModel();
+}
+
+void AudioPlaylist::setItemData(int position, const QVariantList &items)
+{
+    int end = qMin(position + items.count(), m_itemList.count());
+    for(int i = position; i < end; ++i) {
+        if(!m_itemList.at(i)) {
+            m_itemList[i] = new AudioPlaylistItem();
+        }
+        fillItem(m_itemList.at(i), items.at(i - position).toMap());
+    }
+    if(end > position) {
+        emit dataChanged(index(position, 0, QModelIndex()), index(end - 1, 0, QModelIndex()));
+    }
+}
+
+void AudioPlaylist::releaseItems(int start, int end)
+{
+    for(int i = start; i < end; ++i) {
+        delete m_itemList.at(i);
+        m_itemList[i] = 0;
+    }
+    if(end > start) {
+        emit dataChanged(index(start, 0, QModelIndex()), index(end - 1, 0, QModelIndex()));
+    }
+}
 
-    KodiConnection::sendCommand("Playlist.GetItems", params, this, "itemsReceived");
+void AudioPlaylist::fillItem(AudioPlaylistItem *item, const QVariantMap &itemMap)
+{
+    item->setLabel(itemMap.value("label").toString());
+    item->setDuration(QTime(0, 0, 0).addSecs(itemMap.value("duration").toInt()));
+    item->setArtist(itemMap.value("artist").toString());
+    item->setAlbum(itemMap.value("album").toString());
+    item->setThumbnail(itemMap.value("thumbnail").toString());
 }
 
 void AudioPlaylist::queryItemData(int index)
@@ -78,57 +132,43 @@ void AudioPlaylist::queryItemData(int index)
 }
 
 
-void AudioPlaylist::itemsReceived(const QVariantMap &rsp)
-{
-//    koDebug(XDAREA_PLAYLIST) << "AudioPlaylist response:" << rsp;
-
-    koDebug(XDAREA_PLAYLIST) << "got GetItems response:" << rsp;
-    QVariantList responseList = rsp.value("result").toMap().value("items").toList();
-    bool modelResetted = false;
-    if(responseList.count() != m_itemList.count()) {
-        beginResetModel();
-        modelResetted = true;
-    }
-    while(!m_itemList.isEmpty()){
-        delete m_itemList.takeFirst();
-    }
-    foreach(const QVariant &itemVariant, responseList) {
-        QVariantMap itemMap = itemVariant.toMap();
-        AudioPlaylistItem *item = new AudioPlaylistItem();
-        item->setLabel(itemMap.value("label").toString());
-        item->setDuration(QTime(0, 0, 0).addSecs(itemMap.value("duration").toInt()));
-        item->setArtist(itemMap.value("artist").toString());
-        item->setAlbum(itemMap.value("album").toString());
-        item->setThumbnail(itemMap.value("thumbnail").toString());
-        m_itemList.append(item);
-    }
-    if(modelResetted) {
-        endResetModel();
-    } else {
-        emit dataChanged(index(0, 0, QModelIndex()), index(m_itemList.count() - 1, 0, QModelIndex()));
-    }
-    emit countChanged();
-}
-
 void AudioPlaylist::currentDataReceived(const QVariantMap &rsp)
 {
     koDebug(XDAREA_PLAYLIST) << "Current item data response" << rsp;
-    if(m_itemList.count() > m_currentItem && m_currentItem > -1) {
-        AudioPlaylistItem *item = m_itemList.at(m_currentItem);
-        QVariantList responseList = rsp.value("result").toMap().value("items").toList();
+    QVariantList responseList = rsp.value("result").toMap().value("items").toList();
+    if(m_itemList.count() > m_currentItem && m_currentItem > -1 && !responseList.isEmpty()) {
+        if(!m_itemList.at(m_currentItem)) {
+            m_itemList[m_currentItem] = new AudioPlaylistItem();
+        }
+        if(!m_current) {
+            m_current = new AudioPlaylistItem();
+            m_current->setParent(this);
+        }
         QVariantMap itemMap = responseList.first().toMap();
-        item->setLabel(itemMap.value("label").toString());
-        item->setTitle(itemMap.value("title").toString());
-        item->setArtist(itemMap.value("artist").toString());
-        item->setAlbum(itemMap.value("album").toString());
-        item->setFanart(itemMap.value("fanart").toString());
-        item->setThumbnail(itemMap.value("thumbnail").toString());
+        fillDetails(m_itemList.at(m_currentItem), itemMap);
+        fillDetails(static_cast<AudioPlaylistItem*>(m_current), itemMap);
+        m_currentRow = m_currentItem;
         emit currentChanged();
     }
 }
 
+void AudioPlaylist::fillDetails(AudioPlaylistItem *item, const QVariantMap &itemMap)
+{
+    item->setLabel(itemMap.value("label").toString());
+    item->setTitle(itemMap.value("title").toString());
+    item->setArtist(itemMap.value("artist").toString());
+    item->setAlbum(itemMap.value("album").toString());
+    item->setFanart(itemMap.value("fanart").toString());
+    item->setThumbnail(itemMap.value("thumbnail").toString());
+}
+
 QVariant AudioPlaylist::data(const QModelIndex &index, int role) const
 {
+    if(!m_itemList.at(index.row())) {
+        requestItem(index.row());
+        return role == Qt::UserRole+1 ? QVariant("file") : QVariant();
+    }
+
     switch(role) {
     case Qt::DisplayRole:
         return m_itemList.at(index.row())->label();
@@ -42,18 +42,24 @@ public:
     QString title() const;
     int playlistId() const;
 
-public slots:
-    void refresh();
-
 protected:
     void queryItemData(int index);
 
+    QVariantList itemProperties() const;
+    void insertItems(int position, int count);
+    void removeItems(int position, int count);
+    void clearItems();
+    void setItemData(int position, const QVariantList &items);
+    void releaseItems(int start, int end);
+
 private slots:
-    void itemsReceived(const QVariantMap &response);
     void currentDataReceived(const QVariantMap &response);
 
 
 private:
+    static void fillItem(AudioPlaylistItem *item, const QVariantMap &itemMap);
+    static void fillDetails(AudioPlaylistItem *item, const QVariantMap &itemMap);
+
     QList<AudioPlaylistItem*> m_itemList;
 
 };
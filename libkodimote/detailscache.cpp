@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "detailscache.h"
+#include "kodiconnection.h"
+
+#include <QDebug>
+
+KodiDetailsCache::KodiDetailsCache(QObject *parent) :
+    QObject(parent),
+    m_host(0)
+{
+    // Details are small, but plots can be a few kB. Keep the last couple of thousand items.
+    m_cache.setMaxCost(2000);
+
+    connect(KodiConnection::notifier(), SIGNAL(connectionChanged()), SLOT(connectionChanged()));
+    connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
+}
+
+bool KodiDetailsCache::contains(const QString &type, int id) const
+{
+    return m_cache.contains(cacheKey(type, id));
+}
+
+QVariantMap KodiDetailsCache::details(const QString &type, int id) const
+{
+    QVariantMap *details = m_cache.object(cacheKey(type, id));
+    if (!details) {
+        return QVariantMap();
+    }
+    return *details;
+}
+
+void KodiDetailsCache::insert(const QString &type, int id, const QVariantMap &details)
+{
+    m_cache.insert(cacheKey(type, id), new QVariantMap(details));
+}
+
+void KodiDetailsCache::remove(const QString &type, int id)
+{
+    m_cache.remove(cacheKey(type, id));
+}
+
+void KodiDetailsCache::clear()
+{
+    m_cache.clear();
+}
+
+void KodiDetailsCache::connectionChanged()
+{
+    if (KodiConnection::connectedHost() != m_host) {
+        qDebug() << "host changed. clearing details cache";
+        m_host = KodiConnection::connectedHost();
+        clear();
+    }
+}
+
+void KodiDetailsCache::receivedAnnouncement(const QVariantMap &map)
+{
+    QString method = map.value("method").toString();
+    if (method != "VideoLibrary.OnUpdate" && method != "AudioLibrary.OnUpdate") {
+        return;
+    }
+
+    // VideoLibrary wraps the item in "item", AudioLibrary sends type and id directly
+    QVariantMap data = map.value("params").toMap().value("data").toMap();
+    if (data.contains("item")) {
+        data = data.value("item").toMap();
+    }
+    remove(data.value("type").toString(), data.value("id").toInt());
+}
+
+QString KodiDetailsCache::cacheKey(const QString &type, int id)
+{
+    return type + "-" + QString::number(id);
+}
@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef DETAILSCACHE_H
+#define DETAILSCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QVariantMap>
+
+class KodiHost;
+
+/**
+  * Keeps the extended details (plot, rating, ...) of library items around
+  * so detail views don't need a round trip once an item has been seen by
+  * any model. Items are keyed by their Kodi type ("movie", "song", "episode")
+  * and id. Entries are dropped when Kodi announces an update for them or
+  * when we connect to a different host.
+  */
+class KodiDetailsCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KodiDetailsCache(QObject *parent = 0);
+
+    bool contains(const QString &type, int id) const;
+    QVariantMap details(const QString &type, int id) const;
+    void insert(const QString &type, int id, const QVariantMap &details);
+    void remove(const QString &type, int id);
+
+public slots:
+    void clear();
+
+private slots:
+    void connectionChanged();
+    void receivedAnnouncement(const QVariantMap &map);
+
+private:
+    static QString cacheKey(const QString &type, int id);
+
+    QCache<QString, QVariantMap> m_cache;
+    KodiHost *m_host;
+};
+
+#endif // DETAILSCACHE_H
@@ -0,0 +1,145 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "entitystore.h"
+#include "kodiconnection.h"
+#include "libraryitem.h"
+
+#include <QDebug>
+
+// Interned strings are checked for ones nobody uses anymore once there are this many
+static const int minPruneThreshold = 1024;
+
+KodiEntityStore::KodiEntityStore(QObject *parent) :
+    QObject(parent),
+    m_pruneThreshold(minPruneThreshold),
+    m_host(0)
+{
+    connect(KodiConnection::notifier(), SIGNAL(connectionChanged()), SLOT(connectionChanged()));
+    connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
+}
+
+void KodiEntityStore::registerItem(const QString &type, int id, LibraryItem *item)
+{
+    QString itemKey = key(type, id);
+    if (m_itemKeys.contains(item)) {
+        QString oldKey = m_itemKeys.value(item);
+        if (oldKey == itemKey) {
+            return;
+        }
+        m_items.remove(oldKey, item);
+    } else {
+        connect(item, SIGNAL(destroyed(QObject*)), SLOT(itemDestroyed(QObject*)));
+    }
+
+    m_items.insert(itemKey, item);
+    m_itemKeys.insert(item, itemKey);
+}
+
+QList<LibraryItem*> KodiEntityStore::items(const QString &type, int id) const
+{
+    QList<LibraryItem*> list;
+    foreach (QObject *item, m_items.values(key(type, id))) {
+        list.append(static_cast<LibraryItem*>(item));
+    }
+    return list;
+}
+
+QString KodiEntityStore::intern(const QString &string)
+{
+    if (string.isEmpty()) {
+        return string;
+    }
+
+    QSet<QString>::const_iterator it = m_strings.constFind(string);
+    if (it != m_strings.constEnd()) {
+        return *it;
+    }
+    if (m_strings.count() >= m_pruneThreshold) {
+        pruneStrings();
+    }
+    m_strings.insert(string);
+    return string;
+}
+
+void KodiEntityStore::pruneStrings()
+{
+    // A string only we still hold a reference to isn't used by any item anymore
+    QSet<QString>::iterator it = m_strings.begin();
+    while (it != m_strings.end()) {
+        if (it->isDetached()) {
+            it = m_strings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Amortize the walk over the set
+    m_pruneThreshold = qMax(minPruneThreshold, m_strings.count() * 2);
+}
+
+void KodiEntityStore::itemDestroyed(QObject *item)
+{
+    // Don't touch the item, it is already half way gone
+    m_items.remove(m_itemKeys.take(item), item);
+}
+
+void KodiEntityStore::connectionChanged()
+{
+    if (KodiConnection::connectedHost() != m_host) {
+        // Strings are only shared while interned; items still holding them keep their copy
+        m_host = KodiConnection::connectedHost();
+        m_strings.clear();
+        m_pruneThreshold = minPruneThreshold;
+    }
+}
+
+void KodiEntityStore::receivedAnnouncement(const QVariantMap &map)
+{
+    if (map.value("method").toString() != "VideoLibrary.OnUpdate") {
+        return;
+    }
+
+    QVariantMap data = map.value("params").toMap().value("data").toMap();
+
+    QVariant playcount = data.value("playcount");
+    if (!playcount.isValid() || playcount.toInt() < 0) {
+        return;
+    }
+
+    QString type = data.value("item").toMap().value("type").toString();
+    int id = data.value("item").toMap().value("id").toInt();
+
+    bool changed = false;
+    foreach (LibraryItem *item, items(type, id)) {
+        if (item->playcount() != playcount.toInt()) {
+            item->setPlaycount(playcount.toInt());
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        emit itemUpdated(type, id);
+    }
+}
+
+QString KodiEntityStore::key(const QString &type, int id)
+{
+    return type + "-" + QString::number(id);
+}
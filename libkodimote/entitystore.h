@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVariantMap>
+
+class KodiHost;
+class LibraryItem;
+
+/**
+  * Knows about every LibraryItem that represents a library entity (movie, episode, song, musicvideo),
+  * no matter which model (or the player) created it. Library updates announced by Kodi are applied
+  * once here and reach all of them, and itemUpdated() tells the models which rows to refresh.
+  * Additionally it interns frequently repeated strings (genres, artists, albums...) so all items
+  * share one copy of them. Strings no item uses anymore are pruned as the set grows.
+  */
+class KodiEntityStore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KodiEntityStore(QObject *parent = 0);
+
+    void registerItem(const QString &type, int id, LibraryItem *item);
+    QList<LibraryItem*> items(const QString &type, int id) const;
+
+    QString intern(const QString &string);
+
+signals:
+    void itemUpdated(const QString &type, int id);
+
+private slots:
+    void itemDestroyed(QObject *item);
+    void connectionChanged();
+    void receivedAnnouncement(const QVariantMap &map);
+
+private:
+    static QString key(const QString &type, int id);
+    void pruneStrings();
+
+    QMultiHash<QString, QObject*> m_items;
+    QHash<QObject*, QString> m_itemKeys;
+    QSet<QString> m_strings;
+    int m_pruneThreshold;
+    KodiHost *m_host;
+};
+
+#endif // ENTITYSTORE_H
@@ -25,7 +25,9 @@
 #include "videoplaylist.h"
 #include "videoplaylistitem.h"
 #include "libraryitem.h"
+#include "entitystore.h"
 #include "kodidownload.h"
+#include "detailscache.h"
 
 Episodes::Episodes(int tvshowid, int seasonid, const QString &seasonString, KodiModel *parent):
     KodiLibrary(parent),
@@ -33,51 +35,27 @@ Episodes::Episodes(int tvshowid, int seasonid, const QString &seasonString, Kodi
     m_seasonid(seasonid),
     m_seasonString(seasonString)
 {
-    connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
+    // Recently added episodes change all the time, don't cache them
+    if (tvshowid >= ItemIdInvalid && seasonid >= ItemIdInvalid) {
+        setCacheKey(cacheKey(tvshowid, seasonid));
+    }
+    connect(Kodi::instance()->entityStore(), SIGNAL(itemUpdated(QString,int)), SLOT(itemUpdated(QString,int)));
 }
 
-void Episodes::receivedAnnouncement(const QVariantMap &map)
+void Episodes::itemUpdated(const QString &type, int id)
 {
-    QString method = map.value("method").toString();
-
-    if(method != "VideoLibrary.OnUpdate") {
-        return;
-    }
-
-    QVariantMap data = map.value("params").toMap().value("data").toMap();
-
-    QVariant playcount = data.value("playcount");
-    if(!playcount.isValid() || playcount.toInt() < 0) {
-        return;
-    }
-
-    QString type = data.value("item").toMap().value("type").toString();
-    int id = data.value("item").toMap().value("id").toInt();
+    // The item itself has already been updated by the entity store
     if(type != "episode" || !m_idIndexMapping.contains(id)) {
         return;
     }
 
     int i = m_idIndexMapping.value(id);
-    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(i));
-
-    if(playcount.toInt() == item->playcount()) {
-        return;
-    }
-
-
-    item->setPlaycount(playcount.toInt());
-    dataChanged(index(i, 0, QModelIndex()), index(i, 0, QModelIndex()));
+    emit dataChanged(index(i, 0, QModelIndex()), index(i, 0, QModelIndex()));
 }
 
 void Episodes::refresh()
 {
     QVariantMap params;
-    if(m_tvshowid >= 0) {
-        params.insert("tvshowid", m_tvshowid);
-    }
-    if(m_seasonid >= 0) {
-        params.insert("season", m_seasonid);
-    }
     QVariantList properties;
     properties.append("showtitle");
     properties.append("episode");
@@ -86,23 +64,32 @@ void Episodes::refresh()
     properties.append("file");
     params.insert("properties", properties);
 
+    sendListCommand(params, "listReceived");
+}
+
+int Episodes::sendListCommand(QVariantMap params, const QString &callback)
+{
+    if(m_tvshowid >= 0) {
+        params.insert("tvshowid", m_tvshowid);
+    }
+    if(m_seasonid >= 0) {
+        params.insert("season", m_seasonid);
+    }
+
     if (m_tvshowid == KodiModel::ItemIdRecentlyAdded && m_seasonid == KodiModel::ItemIdRecentlyAdded) {
-        KodiConnection::sendCommand("VideoLibrary.GetRecentlyAddedEpisodes", params, this, "listReceived");
-    } else {
-        QVariantMap sort;
-        sort.insert("method", "episode");
-        sort.insert("order", "ascending");
-        params.insert("sort", sort);
-
-        KodiConnection::sendCommand("VideoLibrary.GetEpisodes", params, this, "listReceived");
+        return KodiConnection::sendCommand("VideoLibrary.GetRecentlyAddedEpisodes", params, this, callback);
     }
+
+    QVariantMap sort;
+    sort.insert("method", "episode");
+    sort.insert("order", "ascending");
+    params.insert("sort", sort);
+
+    return KodiConnection::sendCommand("VideoLibrary.GetEpisodes", params, this, callback);
 }
 
-void Episodes::fetchItemDetails(int index)
+QVariantList Episodes::detailsProperties()
 {
-    QVariantMap params;
-    params.insert("episodeid", m_list.at(index)->data(RoleEpisodeId).toInt());
-
     QVariantList properties;
 //    properties.append("resume");
 //    properties.append("title");
@@ -130,12 +117,52 @@ void Episodes::fetchItemDetails(int index)
 //    properties.append("resume");
 //    properties.append("tvshowid");
 
-    params.insert("properties", properties);
+    return properties;
+}
+
+void Episodes::fetchItemDetails(int index)
+{
+    int episodeId = m_list.at(index)->data(RoleEpisodeId).toInt();
+    if (Kodi::instance()->detailsCache()->contains("episode", episodeId)) {
+        setItemDetails(index, Kodi::instance()->detailsCache()->details("episode", episodeId));
+        return;
+    }
+
+    QVariantMap params;
+    params.insert("episodeid", episodeId);
+    params.insert("properties", detailsProperties());
 
     int id = KodiConnection::sendCommand("VideoLibrary.GetEpisodeDetails", params, this, "detailsReceived");
     m_detailsRequestMap.insert(id, index);
 }
 
+void Episodes::prefetchItemDetails(int first, int last)
+{
+    first = qMax(0, first);
+    last = qMin(m_list.count() - 1, last);
+
+    // Only ask for the part of the range that isn't cached yet
+    KodiDetailsCache *cache = Kodi::instance()->detailsCache();
+    while (first <= last && cache->contains("episode", m_list.at(first)->data(RoleEpisodeId).toInt())) {
+        ++first;
+    }
+    while (last >= first && cache->contains("episode", m_list.at(last)->data(RoleEpisodeId).toInt())) {
+        --last;
+    }
+    if (first > last) {
+        return;
+    }
+
+    QVariantMap params;
+    params.insert("properties", detailsProperties());
+    QVariantMap limits;
+    limits.insert("start", first);
+    limits.insert("end", last + 1);
+    params.insert("limits", limits);
+
+    sendListCommand(params, "prefetchReceived");
+}
+
 void Episodes::download(int index, const QString &path)
 {
     LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(index));
@@ -146,6 +173,7 @@ void Episodes::download(int index, const QString &path)
     KodiDownload *download = new KodiDownload();
     download->setDestination(destination);
     download->setIconId("icon-m-content-videos");
+    download->setSegmented(true);
     download->setLabel(item->title());
 
     startDownload(index, download);
@@ -187,8 +215,23 @@ void Episodes::detailsReceived(const QVariantMap &rsp)
     qDebug() << "got item details:" << rsp;
     int id = rsp.value("id").toInt();
     int row = m_detailsRequestMap.take(id);
-    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(row));
     QVariantMap details = rsp.value("result").toMap().value("episodedetails").toMap();
+    Kodi::instance()->detailsCache()->insert("episode", details.value("episodeid").toInt(), details);
+    setItemDetails(row, details);
+}
+
+void Episodes::prefetchReceived(const QVariantMap &rsp)
+{
+    QVariantList responseList = rsp.value("result").toMap().value("episodes").toList();
+    foreach(const QVariant &itemVariant, responseList) {
+        QVariantMap details = itemVariant.toMap();
+        Kodi::instance()->detailsCache()->insert("episode", details.value("episodeid").toInt(), details);
+    }
+}
+
+void Episodes::setItemDetails(int row, const QVariantMap &details)
+{
+    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(row));
     item->setPlot(details.value("plot").toString());
     item->setRating(details.value("rating").toInt());
     item->setSeason(details.value("season").toInt());
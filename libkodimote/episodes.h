@@ -31,6 +31,7 @@ class Episodes : public KodiLibrary
 public:
     // seasonstring is a workaround to pass the label of the season because there is no sane way to qery the label here
     explicit Episodes(int tvshowid = -1, int seasonid = -1, const QString &seasonString = QString(), KodiModel *parent = 0);
+    static QString cacheKey(int tvshowId, int seasonId) { return QString("Episodes/%1/%2").arg(tvshowId).arg(seasonId); }
 
     KodiModel *enterItem(int index);
     void playItem(int index);
@@ -39,6 +40,7 @@ public:
     QString title() const;
 
     Q_INVOKABLE void fetchItemDetails(int index);
+    Q_INVOKABLE void prefetchItemDetails(int first, int last);
     Q_INVOKABLE bool hasDetails() { return true; }
 
     Q_INVOKABLE void download(int index, const QString &path);
@@ -52,9 +54,14 @@ public slots:
 private slots:
     void listReceived(const QVariantMap &rsp);
     void detailsReceived(const QVariantMap &rsp);
-    void receivedAnnouncement(const QVariantMap &map);
+    void prefetchReceived(const QVariantMap &rsp);
+    void itemUpdated(const QString &type, int id);
 
 private:
+    int sendListCommand(QVariantMap params, const QString &callback);
+    static QVariantList detailsProperties();
+    void setItemDetails(int row, const QVariantMap &details);
+
     QMap<int, int> m_detailsRequestMap;
     int m_tvshowid;
     int m_seasonid;
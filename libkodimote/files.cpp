@@ -29,6 +29,7 @@
 #include "videoplaylistitem.h"
 #include "libraryitem.h"
 #include "kodidownload.h"
+#include "kodidownloadjob.h"
 
 Files::Files(const QString &mediaType, const QString &dir, KodiModel *parent):
     KodiLibrary(parent),
@@ -170,6 +171,13 @@ void Files::download(int index, const QString &path)
 {
     LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(index));
 
+    if(item->fileType() == "directory") {
+        qDebug() << "Downloading directory" << item->fileName();
+        KodiDownloadJob *job = new KodiDownloadJob(path, item->title());
+        job->downloadDirectory(item->fileName(), m_mediaType);
+        return;
+    }
+
     QString destination;
     if(m_mediaType == "music") {
         destination = path + "/Music/" + item->tvShow() + "/Season " + item->season() + '/';
@@ -30,6 +30,7 @@
 Genres::Genres(KodiModel *parent) :
     KodiLibrary(parent)
 {
+    setCacheKey(cacheKey());
 }
 
 void Genres::refresh()
@@ -78,7 +79,12 @@ void Genres::listReceived(const QVariantMap &rsp)
 
 KodiModel *Genres::enterItem(int index)
 {
-    return new Artists(m_list.at(index)->data(RoleGenreId).toInt(), this);
+    int genreId = m_list.at(index)->data(RoleGenreId).toInt();
+    KodiModel *model = cachedModel(Artists::cacheKey(genreId));
+    if (!model) {
+        model = new Artists(genreId, this);
+    }
+    return model;
 }
 
 void Genres::playItem(int index)
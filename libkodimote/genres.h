@@ -30,6 +30,7 @@ class Genres: public KodiLibrary
     Q_OBJECT
 public:
     explicit Genres(KodiModel *parent = 0);
+    static QString cacheKey() { return QString("Genres"); }
     ~Genres();
 
     KodiModel *enterItem(int index);
@@ -22,46 +22,216 @@
 #include "kodi.h"
 #include "kodiconnection.h"
 #include "kodihostmodel.h"
+#include "thumbnailpack.h"
 
 #include <QImage>
+#include <QImageReader>
 #include <QFileInfo>
 #include <QDir>
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDebug>
-#include <QtConcurrent/QtConcurrent>
+#ifdef QT5_BUILD
+#include <QGuiApplication>
+#endif
+#include <QRunnable>
+
+// Keep a couple of connections to Kodi free for JSON-RPC and other downloads
+static const int maxActiveDownloads = 4;
+
+// Downloaded images waiting for a decoder. Downloads stall while this is full
+// so we don't pile up compressed payloads faster than we can process them.
+static const int maxPendingScaleJobs = 8;
 
 ImageFetchJob *scaleImage(ImageFetchJob *job, QByteArray data)
 {
     QString cachedFile = job->cachedFile();
     QFileInfo fi = cachedFile;
+    QElapsedTimer timer;
+    timer.start();
 
     if(job->scaleTo().width() > 0 && job->scaleTo().height() > 0) {
         if(fi.suffix() == "png" || fi.suffix() == "jpg") {
-            QImage image = QImage::fromData(data);
-            QImage scaledImage = image.scaled(job->scaleTo().width(), job->scaleTo().height(), Qt::KeepAspectRatio, Qt::FastTransformation);
-            scaledImage.save(cachedFile);
+            QBuffer buffer(&data);
+            QImageReader reader(&buffer);
+            QSize targetSize = reader.size();
+            if(targetSize.width() > job->scaleTo().width() || targetSize.height() > job->scaleTo().height()) {
+                targetSize.scale(job->scaleTo(), Qt::KeepAspectRatio);
+            }
+
+            QImage scaledImage;
+            if(targetSize.isValid() && reader.supportsOption(QImageIOHandler::ScaledSize)) {
+                // Let the decoder subsample (e.g. JPEG DCT scaling) instead of decoding the full image
+                reader.setScaledSize(targetSize);
+                scaledImage = reader.read();
+                job->setStageTime(ImageFetchJob::StageDecode, timer.restart());
+            } else {
+                QImage image = reader.read();
+                job->setStageTime(ImageFetchJob::StageDecode, timer.restart());
+                if(targetSize.isValid() && image.size() != targetSize) {
+                    // Smooth scaling is only cheap on small sources. Cut big ones down fast
+                    // to twice the target first and smooth scale the rest of the way.
+                    if(image.width() > targetSize.width() * 2 && image.height() > targetSize.height() * 2) {
+                        image = image.scaled(targetSize * 2, Qt::KeepAspectRatio, Qt::FastTransformation);
+                    }
+                    image = image.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+                }
+                scaledImage = image;
+                job->setStageTime(ImageFetchJob::StageScale, timer.restart());
+            }
+            if(scaledImage.isNull()) {
+                qDebug() << "cannot decode image" << job->imageName() << reader.errorString();
+                return job;
+            }
+
+            QByteArray encoded;
+            QBuffer encodedBuffer(&encoded);
+            encodedBuffer.open(QIODevice::WriteOnly);
+            if(job->packed()) {
+                scaledImage.save(&encodedBuffer, scaledImage.hasAlphaChannel() ? "PNG" : "JPG");
+            } else {
+                scaledImage.save(&encodedBuffer, fi.suffix() == "png" ? "PNG" : "JPG");
+            }
+            job->setImage(scaledImage);
+            // We have the pixels at hand anyways. Smooth scaling down to a single pixel averages them.
+            job->setPreviewColor(QColor(scaledImage.scaled(1, 1, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).pixel(0, 0)));
+            job->setStageTime(ImageFetchJob::StageEncode, timer.restart());
+            data = encoded;
+        }
+
+        if(job->packed()) {
+            // Written to the pack by the cache itself
+            job->setData(data);
         } else {
             QFile file(cachedFile);
             if(file.open(QIODevice::WriteOnly)) {
                 file.write(data);
             }
+            job->setStageTime(ImageFetchJob::StageWrite, timer.elapsed());
         }
     }
 
     return job;
 }
 
+class ImageScaleTask : public QRunnable
+{
+public:
+    ImageScaleTask(KodiImageCache *imageCache, ImageFetchJob *job, const QByteArray &data) :
+        m_imageCache(imageCache),
+        m_job(job),
+        m_data(data)
+    {
+    }
+
+    void run()
+    {
+        if (m_job->contentHash().isEmpty()) {
+            // Hashing a full size download takes a while too. The cache looks the hash up
+            // and either links a picture it already has or queues the job again for scaling.
+            m_job->setContentHash(QCryptographicHash::hash(m_data, QCryptographicHash::Md5));
+            m_job->setData(m_data);
+            QMetaObject::invokeMethod(m_imageCache, "imageHashed", Qt::QueuedConnection, Q_ARG(QObject*, m_job));
+            return;
+        }
+        scaleImage(m_job, m_data);
+        QMetaObject::invokeMethod(m_imageCache, "imageScaled", Qt::QueuedConnection, Q_ARG(QObject*, m_job));
+    }
+
+private:
+    KodiImageCache *m_imageCache;
+    ImageFetchJob *m_job;
+    QByteArray m_data;
+};
+
 KodiImageCache::KodiImageCache(QObject *parent) :
     QObject(parent),
     m_jobId(0),
-    m_doubleDecode(false)
+    m_activeDownloads(0),
+    m_activeScaleJobs(0),
+    m_maxActiveScaleJobs(qMax(1, QThread::idealThreadCount() - 1)),
+    m_fetchCount(0),
+    m_totalFetchTime(0),
+    m_pathDecodingConfirmed(false),
+    m_decodedImages(32 * 1024), // in KiB
+    m_pack(0),
+    m_previewColorsLoaded(false)
 {
+    // Leave a core for the UI. Other QtConcurrent users keep the global pool for themselves.
+    m_scalePool.setMaxThreadCount(m_maxActiveScaleJobs);
+    for (int i = 0; i < ImageFetchJob::StageCount; ++i) {
+        m_stageTotals[i] = 0;
+        m_stageCounts[i] = 0;
+    }
+
+    connect(KodiConnection::notifier(), SIGNAL(connectionChanged()), SLOT(connectionChanged()));
+}
+
+KodiImageCache::~KodiImageCache()
+{
+    m_scalePool.clear();
+    m_scalePool.waitForDone();
+    delete m_pack;
+}
+
+int KodiImageCache::scaleThreads() const
+{
+    return m_maxActiveScaleJobs;
+}
+
+QThreadPool *KodiImageCache::scalePool()
+{
+    return &m_scalePool;
+}
+
+void KodiImageCache::setScaleThreads(int scaleThreads)
+{
+    m_maxActiveScaleJobs = qMax(1, scaleThreads);
+    m_scalePool.setMaxThreadCount(m_maxActiveScaleJobs);
+    startScaling();
+}
+
+QVariantMap KodiImageCache::stageTimings() const
+{
+    static const char *stageNames[] = { "download", "decode", "scale", "encode", "write" };
+    QVariantMap timings;
+    for (int i = 0; i < ImageFetchJob::StageCount; ++i) {
+        timings.insert(stageNames[i], m_stageCounts[i] > 0 ? m_stageTotals[i] / m_stageCounts[i] : 0);
+    }
+    return timings;
+}
+
+bool KodiImageCache::packed(int cacheId)
+{
+#ifdef QT5_BUILD
+    // Tens of thousands of tiny files are slow to look up and waste space. The image provider
+    // can decode straight out of the pack, Qt4 frontends need files.
+    return cacheId == CacheSmall;
+#else
+    Q_UNUSED(cacheId)
+    return false;
+#endif
+}
+
+KodiThumbnailPack *KodiImageCache::pack()
+{
+    // Created on first use as the data path isn't known at construction time
+    QMutexLocker locker(&m_packMutex);
+    if (!m_pack) {
+        m_pack = new KodiThumbnailPack(cachePath(CacheSmall));
+    }
+    return m_pack;
 }
 
 bool KodiImageCache::contains(const QString &image, int cacheId, QString &cachedFile)
 {
     QString cacheKey = this->cacheKey(image, cacheId);
+    if (packed(cacheId)) {
+        cachedFile.clear();
+        return pack()->contains(cacheKey);
+    }
     if (!m_cacheFiles.contains(cacheKey)) {
         QString path = cachePath(cacheId);
         // Make sure the cache exists
@@ -80,6 +250,29 @@ bool KodiImageCache::contains(const QString &image, int cacheId, QString &cached
     return m_cacheFiles[cacheKey].first;
 }
 
+QString KodiImageCache::cacheFile(const QString &image, int cacheId)
+{
+    if (packed(cacheId)) {
+        return QString();
+    }
+    return cachedFile(cachePath(cacheId), image);
+}
+
+QImage KodiImageCache::decodedImage(const QString &image, int cacheId)
+{
+    {
+        QMutexLocker locker(&m_decodedImagesMutex);
+        QImage *decodedImage = m_decodedImages.object(cacheKey(image, cacheId));
+        if (decodedImage) {
+            return *decodedImage;
+        }
+    }
+    if (packed(cacheId)) {
+        return pack()->image(cacheKey(image, cacheId));
+    }
+    return QImage();
+}
+
 QString KodiImageCache::cachedFile(const QString &path, const QString &image)
 {
     QString filename = image;
@@ -96,9 +289,32 @@ QString KodiImageCache::cachedFile(const QString &path, const QString &image)
     return path + url.path();
 }
 
+QSize KodiImageCache::cacheSize(int cacheId)
+{
+    // Logical sizes of the cache buckets. Small is optimized for list view icons,
+    // large for fullscreen representations.
+    QSize size = cacheId == CacheSmall ? QSize(152, 120) : QSize(1000, 1000);
+    return size * devicePixelRatio();
+}
+
+qreal KodiImageCache::devicePixelRatio()
+{
+#ifdef QT5_BUILD
+    if(qGuiApp) {
+        return qGuiApp->devicePixelRatio();
+    }
+#endif
+    return 1;
+}
+
 QString KodiImageCache::cachePath(int cacheId)
 {
-    return Kodi::instance()->dataPath() + "/imagecache/" + QString::number(cacheId) + "/";
+    // Keep high dpi buckets apart so images are never served at the wrong resolution
+    QString bucket = QString::number(cacheId);
+    if(devicePixelRatio() != 1) {
+        bucket += "@" + QString::number(devicePixelRatio()) + "x";
+    }
+    return Kodi::instance()->dataPath() + "/imagecache/" + bucket + "/";
 }
 
 int KodiImageCache::fetch(const QString &image, QObject *callbackObject, const QString &callbackFunction, const QSize &scaleTo, int cacheId)
@@ -106,6 +322,12 @@ int KodiImageCache::fetch(const QString &image, QObject *callbackObject, const Q
     QString cacheKey = this->cacheKey(image, cacheId);
     ImageFetchJob *job = m_jobs.value(cacheKey);
     if (job) {
+        // Whoever asked last is most likely looking at it right now
+        int pendingIndex = m_pendingJobs.indexOf(job);
+        if (pendingIndex >= 0) {
+            m_pendingJobs.move(pendingIndex, m_pendingJobs.count() - 1);
+        }
+
         foreach (const ImageFetchJob::Callback callback, job->callbacks()) {
             if (callback.object() == callbackObject && callback.method() == callbackFunction) {
                 return job->id();
@@ -122,13 +344,80 @@ int KodiImageCache::fetch(const QString &image, QObject *callbackObject, const Q
 
     // Ok... this is a new one... start fetching it
     ImageFetchJob *ifJob = new ImageFetchJob(m_jobId++, cacheId, image, cachedFile, scaleTo);
+    ifJob->setPacked(packed(cacheId));
     ifJob->appendCallback(QPointer<QObject>(callbackObject), callbackFunction);
     m_jobs.insert(cacheKey, ifJob);
-    fetchNext(ifJob);
+    m_pendingJobs.append(ifJob);
+    startJobs();
 
     return ifJob->id();
 }
 
+void KodiImageCache::cancel(int id, QObject *callbackObject)
+{
+    for (int i = m_pendingJobs.count() - 1; i >= 0; --i) {
+        ImageFetchJob *job = m_pendingJobs.at(i);
+        if (job->id() != id) {
+            continue;
+        }
+        job->removeCallbacks(callbackObject);
+        if (!job->hasCallbacks()) {
+            m_pendingJobs.removeAt(i);
+            m_jobs.remove(cacheKey(job->imageName(), job->cacheId()));
+            job->deleteLater();
+            emit queueLengthChanged();
+        }
+        return;
+    }
+}
+
+int KodiImageCache::queueLength() const
+{
+    return m_pendingJobs.count();
+}
+
+int KodiImageCache::averageFetchTime() const
+{
+    return m_fetchCount > 0 ? m_totalFetchTime / m_fetchCount : 0;
+}
+
+void KodiImageCache::startJobs()
+{
+    while (m_activeDownloads < maxActiveDownloads && m_pendingScaleJobs.count() < maxPendingScaleJobs && !m_pendingJobs.isEmpty()) {
+        ImageFetchJob *job = m_pendingJobs.takeLast();
+        if (!job->hasCallbacks()) {
+            // Everyone who wanted this is gone already
+            m_jobs.remove(cacheKey(job->imageName(), job->cacheId()));
+            job->deleteLater();
+            continue;
+        }
+        m_activeDownloads++;
+        fetchNext(job);
+    }
+    emit queueLengthChanged();
+}
+
+void KodiImageCache::startScaling()
+{
+    while (m_activeScaleJobs < m_maxActiveScaleJobs && !m_pendingScaleJobs.isEmpty()) {
+        ImageFetchJob *job = m_pendingScaleJobs.takeLast();
+        m_activeScaleJobs++;
+        QByteArray data = job->data();
+        job->setData(QByteArray());
+        m_scalePool.start(new ImageScaleTask(this, job, data));
+    }
+}
+
+void KodiImageCache::failJob(ImageFetchJob *job)
+{
+    m_jobs.remove(cacheKey(job->imageName(), job->cacheId()));
+    emit fetchFailed(job->id());
+    job->deleteLater();
+
+    m_activeDownloads--;
+    startJobs();
+}
+
 QString KodiImageCache::cacheKey(const QString &image, int cacheId)
 {
     return image + "-" + QString::number(cacheId);
@@ -138,31 +427,38 @@ void KodiImageCache::imageFetched()
 {
     QNetworkReply *reply = static_cast<QNetworkReply*>(sender());
     ImageFetchJob *job = static_cast<ImageFetchJob*>(reply->request().originatingObject());
-    QString cacheKey = this->cacheKey(job->imageName(), job->cacheId());
+    job->setStageTime(ImageFetchJob::StageDownload, job->stageElapsed());
 
     reply->request().setOriginatingObject(0);
     reply->deleteLater();
 
     if(reply->error() == QNetworkReply::NoError) {
+        KodiHost *host = KodiConnection::connectedHost();
+        if (host) {
+            host->setImagePathDecoding((KodiHost::ImagePathDecoding)job->pathDecoding());
+        }
+        m_pathDecodingConfirmed = true;
+
         job->setParent(this);
-        QFutureWatcher<ImageFetchJob*> *watcher = new QFutureWatcher<ImageFetchJob*>();
-        connect(watcher, SIGNAL(finished()), this, SLOT(imageScaled()));
-        watcher->setFuture(QtConcurrent::run(scaleImage, job, reply->readAll()));
+        job->setData(reply->readAll());
+        m_pendingScaleJobs.append(job);
+        startScaling();
+
+        m_activeDownloads--;
+        startJobs();
         return;
     } else {
         qDebug() << "image fetching failed" << reply->errorString() << reply->error();
 
         // Hack: There is something fishy with Kodi's image urls. Some versions require decoding
-        // from PercentageDecoding once, some twice... Let's retry doubleDecoding if if we get a 404
-        if (reply->error() == QNetworkReply::ContentNotFoundError) {
-            if (!m_doubleDecode) {
-                m_doubleDecode = true;
-                fetchNext(job);
-                return;
-            } else {
-                // So this failed with both... Lets turn off doubleDecode again and try the next
-                m_doubleDecode = false;
-            }
+        // from PercentageDecoding once, some twice... Until one of them worked on this connection,
+        // retry with the other one if we get a 404. Afterwards a 404 just means there is no image.
+        if (reply->error() == QNetworkReply::ContentNotFoundError && !m_pathDecodingConfirmed && !job->retried()) {
+            job->setRetried(true);
+            job->setPathDecoding(job->pathDecoding() == KodiHost::ImagePathDecodingDouble ?
+                                     KodiHost::ImagePathDecodingSingle : KodiHost::ImagePathDecodingDouble);
+            fetchNext(job);
+            return;
         }
 
         QVariant possibleRedirectUrl = reply->attribute(QNetworkRequest::RedirectionTargetAttribute);
@@ -173,77 +469,255 @@ void KodiImageCache::imageFetched()
         }
     }
 
-    m_jobs.remove(cacheKey);
+    failJob(job);
 }
 
-void KodiImageCache::imageScaled()
+void KodiImageCache::imageHashed(QObject *hashedJob)
+{
+    ImageFetchJob *job = static_cast<ImageFetchJob*>(hashedJob);
+    m_activeScaleJobs--;
+
+    if (storeDuplicate(job, job->contentHash())) {
+        job->setData(QByteArray());
+        finishJob(job, true);
+    } else {
+        // Jobs are taken from the back, so it's up next
+        m_pendingScaleJobs.append(job);
+    }
+    startScaling();
+    startJobs();
+}
+
+void KodiImageCache::imageScaled(QObject *scaledJob)
+{
+    ImageFetchJob *job = static_cast<ImageFetchJob*>(scaledJob);
+    m_activeScaleJobs--;
+    startScaling();
+    // Room in the decoding queue again, let stalled downloads continue
+    startJobs();
+
+    QString cacheKey = this->cacheKey(job->imageName(), job->cacheId());
+    bool stored = job->packed() ? pack()->insert(cacheKey, job->data()) : QFile::exists(job->cachedFile());
+    if (stored) {
+        addContentHash(job->cacheId(), job->contentHash(), job->imageName());
+    }
+    finishJob(job, stored);
+}
+
+void KodiImageCache::finishJob(ImageFetchJob *job, bool stored)
 {
-    QFutureWatcher<ImageFetchJob*> *watcher = static_cast<QFutureWatcher<ImageFetchJob*>*>(QObject::sender());
-    watcher->deleteLater();
-    ImageFetchJob *job = watcher->result();
-    QString cachedFile = job->cachedFile();
     QString cacheKey = this->cacheKey(job->imageName(), job->cacheId());
+    m_jobs.remove(cacheKey);
+    job->deleteLater();
 
-    m_cacheFiles.insert(cacheKey, QPair<bool, QString>(true, cachedFile));
+    if (!stored) {
+        emit fetchFailed(job->id());
+        return;
+    }
+
+    m_fetchCount++;
+    m_totalFetchTime += job->elapsed();
+    emit averageFetchTimeChanged();
+
+    for (int i = 0; i < ImageFetchJob::StageCount; ++i) {
+        if (job->stageTime(i) >= 0) {
+            m_stageTotals[i] += job->stageTime(i);
+            m_stageCounts[i]++;
+        }
+    }
+
+    if (!job->packed()) {
+        m_cacheFiles.insert(cacheKey, QPair<bool, QString>(true, job->cachedFile()));
+    }
+    if (job->previewColor().isValid()) {
+        addPreviewColor(job->imageName(), job->previewColor());
+    }
+    if (!job->image().isNull()) {
+        QMutexLocker locker(&m_decodedImagesMutex);
+        m_decodedImages.insert(cacheKey, new QImage(job->image()), qMax(1, job->image().byteCount() / 1024));
+    }
 
     foreach (const ImageFetchJob::Callback callback, job->callbacks()) {
         QMetaObject::invokeMethod(callback.object().data(), callback.method().toLatin1(), Qt::QueuedConnection, Q_ARG(int, job->id()));
     }
+}
 
-    job->deleteLater();
+bool KodiImageCache::storeDuplicate(ImageFetchJob *job, const QByteArray &contentHash)
+{
+    // Kodi hands out a different url for the same embedded cover of every track of an album.
+    // If we already have the very same picture, just point this one to it.
+    QString original = contentHashes(job->cacheId()).value(contentHash);
+    if (original.isEmpty() || original == job->imageName()) {
+        return false;
+    }
+
+    QString originalKey = cacheKey(original, job->cacheId());
+    if (job->packed()) {
+        if (!pack()->alias(cacheKey(job->imageName(), job->cacheId()), originalKey)) {
+            return false;
+        }
+    } else {
+        QString originalFile = cachedFile(cachePath(job->cacheId()), original);
+        if (!QFile::exists(originalFile)) {
+            return false;
+        }
+        // Only replace what we have once the link is in place. Not every file system does links.
+        QString linkFile = job->cachedFile() + ".link";
+        QFile::remove(linkFile);
+        if (!QFile::link(originalFile, linkFile)) {
+            return false;
+        }
+        QFile::remove(job->cachedFile());
+        if (!QFile::rename(linkFile, job->cachedFile())) {
+            QFile::remove(linkFile);
+            return false;
+        }
+    }
+
+    job->setPreviewColor(previewColor(original));
+
+    QMutexLocker locker(&m_decodedImagesMutex);
+    QImage *originalImage = m_decodedImages.object(originalKey);
+    if (originalImage) {
+        // Implicitly shared, the pixels stay in memory once
+        job->setImage(*originalImage);
+    }
+    return true;
+}
+
+QHash<QByteArray, QString> &KodiImageCache::contentHashes(int cacheId)
+{
+    if (!m_contentHashes.contains(cacheId)) {
+        QHash<QByteArray, QString> &hashes = m_contentHashes[cacheId];
+        QFile file(cachePath(cacheId) + "contenthashes");
+        if (file.open(QIODevice::ReadOnly)) {
+            QDataStream stream(&file);
+            stream.setVersion(QDataStream::Qt_4_6);
+            while (!stream.atEnd()) {
+                QByteArray contentHash;
+                QString image;
+                stream >> contentHash >> image;
+                if (stream.status() != QDataStream::Ok) {
+                    break;
+                }
+                hashes.insert(contentHash, image);
+            }
+        }
+    }
+    return m_contentHashes[cacheId];
+}
+
+QColor KodiImageCache::previewColor(const QString &image)
+{
+    if (!m_previewColorsLoaded) {
+        m_previewColorsLoaded = true;
+        QFile file(previewColorsFile());
+        if (file.open(QIODevice::ReadOnly)) {
+            QDataStream stream(&file);
+            stream.setVersion(QDataStream::Qt_4_6);
+            while (!stream.atEnd()) {
+                QString image;
+                quint32 color;
+                stream >> image >> color;
+                if (stream.status() != QDataStream::Ok) {
+                    break;
+                }
+                m_previewColors.insert(image, color);
+            }
+        }
+    }
+
+    QHash<QString, QRgb>::const_iterator it = m_previewColors.constFind(image);
+    if (it == m_previewColors.constEnd()) {
+        return QColor();
+    }
+    return QColor::fromRgba(it.value());
+}
+
+void KodiImageCache::addPreviewColor(const QString &image, const QColor &color)
+{
+    // Small and large versions of the same image average out the same
+    if (previewColor(image).isValid()) {
+        return;
+    }
+    m_previewColors.insert(image, color.rgba());
+
+    QDir().mkpath(QFileInfo(previewColorsFile()).absolutePath());
+    QFile file(previewColorsFile());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_4_6);
+        stream << image << (quint32)color.rgba();
+    }
+}
+
+QString KodiImageCache::previewColorsFile() const
+{
+    return Kodi::instance()->dataPath() + "/imagecache/previewcolors";
+}
+
+void KodiImageCache::addContentHash(int cacheId, const QByteArray &contentHash, const QString &image)
+{
+    if (contentHash.isEmpty() || contentHashes(cacheId).value(contentHash) == image) {
+        return;
+    }
+    contentHashes(cacheId).insert(contentHash, image);
+
+    QDir().mkpath(cachePath(cacheId));
+    QFile file(cachePath(cacheId) + "contenthashes");
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_4_6);
+        stream << contentHash << image;
+    }
 }
 
 void KodiImageCache::fetchNext(ImageFetchJob *job)
 {
-    QString cacheKey = this->cacheKey(job->imageName(), job->cacheId());
     QFileInfo fi(job->cachedFile());
     QDir dir(fi.absolutePath());
-    if(!(dir.exists() || dir.mkpath(fi.absolutePath()))) {
+    if(!job->packed() && !(dir.exists() || dir.mkpath(fi.absolutePath()))) {
         qDebug() << "cannot open file." << job->cachedFile() << "won't fetch artwork";
-        m_jobs.remove(cacheKey);
-        job->deleteLater();
+        failJob(job);
         return;
     }
 
-    QVariantMap params;
-    params.insert("path", job->imageName());
-    int id = KodiConnection::sendParallelCommand("Files.PrepareDownload", params, this, "downloadPrepared");
-    m_fetchQueue.insert(id, cacheKey);
-}
-
-void KodiImageCache::downloadPrepared(const QVariantMap &rsp)
-{
-    QVariantMap result = rsp.value("result").toMap();
     KodiHost *host = KodiConnection::connectedHost();
-
-    if(host == 0 || result.isEmpty()) {
+    if(host == 0) {
+        failJob(job);
         return;
     }
 
-    int id = rsp.value("id").toInt();
-    QString cacheKey = m_fetchQueue[id];
-    ImageFetchJob *job = m_jobs[cacheKey];
+    if(job->pathDecoding() == KodiHost::ImagePathDecodingUnknown) {
+        job->setPathDecoding(host->imagePathDecoding() == KodiHost::ImagePathDecodingDouble ?
+                                 KodiHost::ImagePathDecodingDouble : KodiHost::ImagePathDecodingSingle);
+    }
 
-    QUrl imageUrl;
+    job->startStage();
+    QNetworkRequest imageRequest(imageUrl(host, job->imageName(), job->pathDecoding()));
+    imageRequest.setOriginatingObject(job);
+    QNetworkReply *reply = KodiConnection::nam()->get(imageRequest);
+    connect(reply, SIGNAL(finished()), SLOT(imageFetched()));
+}
 
-#ifdef QT5_BUILD
-    if (m_doubleDecode) {
-        QByteArray path = "/" + QByteArray::fromPercentEncoding(result.value("details").toMap().value("path").toByteArray());
-        imageUrl = QUrl::fromEncoded(path);
+QUrl KodiImageCache::imageUrl(KodiHost *host, const QString &image, int pathDecoding)
+{
+    // Build the same url Files.PrepareDownload would hand out, without the round trip
+    QByteArray path = image.startsWith("image://") ? "/image/" : "/vfs/";
+    if(pathDecoding == KodiHost::ImagePathDecodingDouble) {
+        path += image.toUtf8();
     } else {
-        imageUrl = QUrl::fromEncoded("/" + result.value("details").toMap().value("path").toByteArray());
+        path += QUrl::toPercentEncoding(image);
     }
-#else
-    QString path = "/" + QUrl::fromPercentEncoding(result.value("details").toMap().value("path").toByteArray());
-    imageUrl.setPath(path);
-#endif
 
-    imageUrl.setScheme(result.value("protocol").toString());
+    QUrl imageUrl = QUrl::fromEncoded(path);
+    imageUrl.setScheme("http");
     imageUrl.setHost(host->address());
     imageUrl.setPort(host->port());
+    return imageUrl;
+}
 
-    QNetworkRequest imageRequest(imageUrl);
-    imageRequest.setOriginatingObject(job);
-    QNetworkReply *reply = KodiConnection::nam()->get(imageRequest);
-    connect(reply, SIGNAL(finished()), SLOT(imageFetched()));
+void KodiImageCache::connectionChanged()
+{
+    m_pathDecodingConfirmed = false;
 }
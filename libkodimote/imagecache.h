@@ -30,8 +30,16 @@
 #include <QVariantMap>
 #include <QSize>
 #include <QTimer>
+#include <QCache>
+#include <QImage>
+#include <QElapsedTimer>
+#include <QColor>
+#include <QThreadPool>
 
 class QNetworkReply;
+class QUrl;
+class KodiHost;
+class KodiThumbnailPack;
 
 class ImageFetchJob;
 class QFile;
@@ -40,11 +48,68 @@ class QFile;
 class KodiImageCache : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(int queueLength READ queueLength NOTIFY queueLengthChanged)
+    Q_PROPERTY(int averageFetchTime READ averageFetchTime NOTIFY averageFetchTimeChanged)
+    Q_PROPERTY(int scaleThreads READ scaleThreads WRITE setScaleThreads)
 public:
+    enum CacheId {
+        CacheSmall = 0,
+        CacheLarge = 1
+    };
+
     explicit KodiImageCache(QObject *parent = 0);
+    ~KodiImageCache();
+
+    /**
+      * Returns the size images in the given cache are scaled to, in device pixels
+      */
+    static QSize cacheSize(int cacheId);
     
     bool contains(const QString &image, int cacheId, QString &cachedFile);
 
+    /**
+      * Returns the decoded version of "image" if it has been scaled recently, a null image otherwise
+      * Safe to be called from any thread
+      */
+    QImage decodedImage(const QString &image, int cacheId);
+
+    /**
+      * Returns true if images in the given cache are stored in a thumbnail pack instead of single files
+      * For those, contains() doesn't return a file name and images can only be retrieved via decodedImage()
+      */
+    static bool packed(int cacheId);
+
+    /**
+      * Returns the file "image" is stored in once it's cached, an empty string for packed caches
+      * Unlike contains() this checks nothing and is safe to be called from any thread
+      */
+    static QString cacheFile(const QString &image, int cacheId);
+
+    /**
+      * Returns the average colour of "image" if it has been fetched before, an invalid colour otherwise
+      * Meant for placeholders while the actual image is loading
+      */
+    QColor previewColor(const QString &image);
+
+    // Number of jobs waiting for a download slot
+    int queueLength() const;
+    // Average time in ms from requesting an image until it is ready
+    int averageFetchTime() const;
+
+    // Number of threads decoding and scaling images
+    int scaleThreads() const;
+    void setScaleThreads(int scaleThreads);
+    // The threads above. Other image decoding runs here too so it doesn't compete with scaling for the cores.
+    QThreadPool *scalePool();
+
+    // Average time in ms spent in each stage (download, decode, scale, encode, write) of a fetch
+    Q_INVOKABLE QVariantMap stageTimings() const;
+
+signals:
+    void fetchFailed(int id);
+    void queueLengthChanged();
+    void averageFetchTimeChanged();
+
 public slots:
     /**
       * Fetch "image" and report back to "callbackObject" by invoking "callbackFunction"
@@ -57,37 +122,97 @@ public slots:
       */
     int fetch(const QString &image, QObject *callbackObject, const QString &callbackFunction, const QSize &scaleTo = QSize(0, 0), int cacheId = 0);
 
+    /**
+      * Stop reporting job "id" to "callbackObject"
+      * Jobs are processed last-in-first-out. Once nobody waits for a queued job anymore it is dropped
+      * before it hits the network. Jobs that are already downloading are finished and cached.
+      */
+    void cancel(int id, QObject *callbackObject);
+
 private slots:
     void imageFetched();
 
     void fetchNext(ImageFetchJob *job);
-    void downloadPrepared(const QVariantMap &map);
-    void imageScaled();
+    void startJobs();
+    void startScaling();
+    void imageHashed(QObject *hashedJob);
+    void imageScaled(QObject *scaledJob);
+    void connectionChanged();
 private:
     static QString cacheKey(const QString &image, int cacheId);
     static QString cachedFile(const QString &path, const QString &image);
     static QString cachePath(int cacheId);
+    static qreal devicePixelRatio();
+    static QUrl imageUrl(KodiHost *host, const QString &image, int pathDecoding);
+
+    void failJob(ImageFetchJob *job);
+    void finishJob(ImageFetchJob *job, bool stored);
+    bool storeDuplicate(ImageFetchJob *job, const QByteArray &contentHash);
+    QHash<QByteArray, QString> &contentHashes(int cacheId);
+    void addContentHash(int cacheId, const QByteArray &contentHash, const QString &image);
+    void addPreviewColor(const QString &image, const QColor &color);
+    QString previewColorsFile() const;
+    KodiThumbnailPack *pack();
 
     int m_jobId;
 
     QHash<QString, ImageFetchJob*> m_jobs;
+    QList<ImageFetchJob*> m_pendingJobs;
+    QList<ImageFetchJob*> m_pendingScaleJobs;
+    int m_activeDownloads;
+    int m_activeScaleJobs;
+    int m_maxActiveScaleJobs;
+
+    int m_fetchCount;
+    qint64 m_totalFetchTime;
+    // Indexed by ImageFetchJob::Stage
+    qint64 m_stageTotals[5];
+    int m_stageCounts[5];
+
+    QThreadPool m_scalePool;
 
     QHash<QString, QPair<bool, QString> > m_cacheFiles;
-    QHash<int, QString> m_fetchQueue;
+    bool m_pathDecodingConfirmed;
 
-    bool m_doubleDecode;
+    QCache<QString, QImage> m_decodedImages;
+    QMutex m_decodedImagesMutex;
+
+    KodiThumbnailPack *m_pack;
+    QMutex m_packMutex;
+
+    // cacheId -> content hash -> the image that got stored for it
+    QHash<int, QHash<QByteArray, QString> > m_contentHashes;
+
+    QHash<QString, QRgb> m_previewColors;
+    bool m_previewColorsLoaded;
 };
 
 class ImageFetchJob : public QObject
 {
 public:
+    enum Stage {
+        StageDownload,
+        StageDecode,
+        StageScale,
+        StageEncode,
+        StageWrite,
+        StageCount
+    };
+
     ImageFetchJob(int id, int cacheId, const QString &imageName, const QString &cachedFile, const QSize &scaleTo = QSize(0, 0)) :
         m_id(id),
         m_cacheId(cacheId),
         m_imageName(imageName),
         m_cachedFile(cachedFile),
-        m_scalingSize(scaleTo)
+        m_scalingSize(scaleTo),
+        m_pathDecoding(0),
+        m_retried(false),
+        m_packed(false)
     {
+        m_timer.start();
+        for (int i = 0; i < StageCount; ++i) {
+            m_stageTimes[i] = -1;
+        }
     }
     ~ImageFetchJob()
     {
@@ -113,8 +238,44 @@ public:
     QString cachedFile() const { return m_cachedFile; }
     QSize scaleTo() const { return m_scalingSize; }
     QList<Callback> callbacks() const { return m_callbacks; }
+    QImage image() const { return m_image; }
+    void setImage(const QImage &image) { m_image = image; }
+    int pathDecoding() const { return m_pathDecoding; }
+    void setPathDecoding(int pathDecoding) { m_pathDecoding = pathDecoding; }
+    bool retried() const { return m_retried; }
+    void setRetried(bool retried) { m_retried = retried; }
+    QByteArray data() const { return m_data; }
+    void setData(const QByteArray &data) { m_data = data; }
+    qint64 elapsed() const { return m_timer.elapsed(); }
+    void startStage() { m_stageTimer.start(); }
+    qint64 stageElapsed() const { return m_stageTimer.elapsed(); }
+    qint64 stageTime(int stage) const { return m_stageTimes[stage]; }
+    void setStageTime(int stage, qint64 time) { m_stageTimes[stage] = time; }
+    bool packed() const { return m_packed; }
+    void setPacked(bool packed) { m_packed = packed; }
+    QByteArray contentHash() const { return m_contentHash; }
+    void setContentHash(const QByteArray &contentHash) { m_contentHash = contentHash; }
+    QColor previewColor() const { return m_previewColor; }
+    void setPreviewColor(const QColor &previewColor) { m_previewColor = previewColor; }
 
     void appendCallback(QPointer<QObject> object, const QString &method) { m_callbacks.append(Callback(object, method)); }
+    void removeCallbacks(QObject *object)
+    {
+        for (int i = m_callbacks.count() - 1; i >= 0; --i) {
+            if (m_callbacks.at(i).object() == object) {
+                m_callbacks.removeAt(i);
+            }
+        }
+    }
+    bool hasCallbacks() const
+    {
+        foreach (const Callback &callback, m_callbacks) {
+            if (!callback.object().isNull()) {
+                return true;
+            }
+        }
+        return false;
+    }
 
 private:
     int m_id;
@@ -123,6 +284,16 @@ private:
     QString m_cachedFile;
     QSize m_scalingSize;
     QList<Callback> m_callbacks;
+    QImage m_image;
+    int m_pathDecoding;
+    bool m_retried;
+    QByteArray m_data;
+    QElapsedTimer m_timer;
+    QElapsedTimer m_stageTimer;
+    qint64 m_stageTimes[StageCount];
+    bool m_packed;
+    QByteArray m_contentHash;
+    QColor m_previewColor;
 };
 
 #endif // IMAGECACHE_H
@@ -0,0 +1,224 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "imageprovider.h"
+#include "imagecache.h"
+#include "kodi.h"
+
+#include <QImageReader>
+#include <QThread>
+#include <QThreadPool>
+#include <QFile>
+#include <QDebug>
+
+KodiImageProvider::KodiImageProvider()
+#if QT_VERSION < QT_VERSION_CHECK(5, 6, 0)
+    : QQuickImageProvider(QQuickImageProvider::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
+#endif
+{
+}
+
+QString KodiImageProvider::url(const QString &image, int cacheId)
+{
+    // Kodi's image paths are percent encoded urls themselves. Hex them so QML's url
+    // normalization can't mangle them on the way back to us.
+    return "image://kodi/" + QString::number(cacheId) + "/" + QString::fromLatin1(image.toUtf8().toHex());
+}
+
+bool KodiImageProvider::parseId(const QString &id, QString &image, int &cacheId)
+{
+    int separator = id.indexOf('/');
+    if (separator <= 0) {
+        return false;
+    }
+    cacheId = id.left(separator).toInt();
+    image = QString::fromUtf8(QByteArray::fromHex(id.mid(separator + 1).toLatin1()));
+    return true;
+}
+
+QImage KodiImageProvider::loadImage(const QString &image, int cacheId, const QSize &requestedSize)
+{
+    QImage result = Kodi::instance()->imageCache()->decodedImage(image, cacheId);
+
+    if (result.isNull()) {
+        // Packed caches are only available decoded
+        QString cachedFile = KodiImageCache::cacheFile(image, cacheId);
+        if (cachedFile.isEmpty() || !QFile::exists(cachedFile)) {
+            return result;
+        }
+        QImageReader reader(cachedFile);
+        if (requestedSize.isValid()) {
+            QSize scaledSize = reader.size();
+            scaledSize.scale(requestedSize, Qt::KeepAspectRatio);
+            if (scaledSize.isValid() && scaledSize.width() < reader.size().width()) {
+                reader.setScaledSize(scaledSize);
+            }
+        }
+        result = reader.read();
+        if (result.isNull()) {
+            qDebug() << "cannot decode cached image" << cachedFile << reader.errorString();
+            return result;
+        }
+    }
+
+    if (requestedSize.isValid() && (result.width() > requestedSize.width() || result.height() > requestedSize.height())) {
+        result = result.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return result;
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+QQuickImageResponse *KodiImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    QString image;
+    int cacheId = 0;
+    parseId(id, image, cacheId);
+
+    ImageProviderResponse *response = new ImageProviderResponse(image, cacheId, requestedSize);
+    response->moveToThread(Kodi::instance()->imageCache()->thread());
+    QMetaObject::invokeMethod(response, "start", Qt::QueuedConnection);
+    return response;
+}
+
+ImageDecodeTask::ImageDecodeTask(const QString &image, int cacheId, const QSize &requestedSize) :
+    m_image(image),
+    m_cacheId(cacheId),
+    m_requestedSize(requestedSize)
+{
+}
+
+void ImageDecodeTask::run()
+{
+    emit decoded(KodiImageProvider::loadImage(m_image, m_cacheId, m_requestedSize));
+}
+
+ImageProviderResponse::ImageProviderResponse(const QString &image, int cacheId, const QSize &requestedSize) :
+    m_image(image),
+    m_cacheId(cacheId),
+    m_requestedSize(requestedSize),
+    m_jobId(-1),
+    m_fetched(false),
+    m_finished(false)
+{
+}
+
+QQuickTextureFactory *ImageProviderResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_result);
+}
+
+QString ImageProviderResponse::errorString() const
+{
+    return m_error;
+}
+
+void ImageProviderResponse::start()
+{
+    if (m_image.isEmpty()) {
+        finish("Invalid image id");
+        return;
+    }
+    // Try the cache first, we only go to the network if it's not there
+    decode();
+}
+
+void ImageProviderResponse::decode()
+{
+    // The connection is dropped if we get cancelled and deleted in the meantime
+    ImageDecodeTask *task = new ImageDecodeTask(m_image, m_cacheId, m_requestedSize);
+    connect(task, SIGNAL(decoded(QImage)), SLOT(imageDecoded(QImage)), Qt::QueuedConnection);
+    Kodi::instance()->imageCache()->scalePool()->start(task);
+}
+
+void ImageProviderResponse::imageDecoded(const QImage &image)
+{
+    if (m_finished) {
+        return;
+    }
+    if (!image.isNull()) {
+        m_result = image;
+        finish();
+    } else if (!m_fetched) {
+        KodiImageCache *imageCache = Kodi::instance()->imageCache();
+        connect(imageCache, SIGNAL(fetchFailed(int)), SLOT(fetchFailed(int)));
+        m_jobId = imageCache->fetch(m_image, this, "imageFetched", KodiImageCache::cacheSize(m_cacheId), m_cacheId);
+    } else {
+        finish("Cannot decode image");
+    }
+}
+
+void ImageProviderResponse::imageFetched(int id)
+{
+    if (id == m_jobId) {
+        m_jobId = -1;
+        m_fetched = true;
+        disconnect(Kodi::instance()->imageCache(), 0, this, 0);
+        decode();
+    }
+}
+
+void ImageProviderResponse::fetchFailed(int id)
+{
+    if (id == m_jobId) {
+        m_jobId = -1;
+        finish("Cannot fetch image");
+    }
+}
+
+void ImageProviderResponse::cancel()
+{
+    if (m_jobId >= 0) {
+        Kodi::instance()->imageCache()->cancel(m_jobId, this);
+        m_jobId = -1;
+    }
+    disconnect(Kodi::instance()->imageCache(), 0, this, 0);
+    m_finished = true;
+}
+
+void ImageProviderResponse::finish(const QString &error)
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_error = error;
+    disconnect(Kodi::instance()->imageCache(), 0, this, 0);
+    emit finished();
+}
+
+#else
+
+QImage KodiImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    QString image;
+    int cacheId = 0;
+    if (!parseId(id, image, cacheId)) {
+        return QImage();
+    }
+
+    // Never wait for the network here, QML loads all provider images one by one on a
+    // single thread. The models fetch the image and only hand out the url once it's cached.
+    QImage result = loadImage(image, cacheId, requestedSize);
+    if (size) {
+        *size = result.size();
+    }
+    return result;
+}
+#endif
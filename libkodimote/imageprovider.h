@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef IMAGEPROVIDER_H
+#define IMAGEPROVIDER_H
+
+#include <QtGlobal>
+#include <QRunnable>
+#include <QImage>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+#include <QQuickAsyncImageProvider>
+#else
+#include <QQuickImageProvider>
+#endif
+
+/**
+  * Serves artwork to QML as image://kodi/<cacheId>/<image>
+  * Images are fetched through KodiImageCache and decoded on a worker thread, so neither
+  * the GUI thread nor QML's image loader ever waits for the network.
+  * Before Qt 5.6 there are no asynchronous image providers. There only images that are
+  * already in the cache are served and the models hand out the url once they are.
+  */
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+class KodiImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    KodiImageProvider();
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize);
+#else
+class KodiImageProvider : public QQuickImageProvider
+{
+public:
+    KodiImageProvider();
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize);
+#endif
+
+    static QString url(const QString &image, int cacheId);
+
+    /**
+      * Decodes "image" from the cache, scaled down to "requestedSize" if given
+      * Returns a null image if it's not cached yet. Safe to be called from any thread
+      */
+    static QImage loadImage(const QString &image, int cacheId, const QSize &requestedSize);
+
+private:
+    static bool parseId(const QString &id, QString &image, int &cacheId);
+};
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+// Decodes a cached image on the global thread pool
+class ImageDecodeTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    ImageDecodeTask(const QString &image, int cacheId, const QSize &requestedSize);
+
+    void run();
+
+signals:
+    void decoded(const QImage &image);
+
+private:
+    QString m_image;
+    int m_cacheId;
+    QSize m_requestedSize;
+};
+
+// Lives in the image cache's thread and finishes once the image is fetched and decoded
+class ImageProviderResponse : public QQuickImageResponse
+{
+    Q_OBJECT
+public:
+    ImageProviderResponse(const QString &image, int cacheId, const QSize &requestedSize);
+
+    QQuickTextureFactory *textureFactory() const;
+    QString errorString() const;
+
+    Q_INVOKABLE void imageFetched(int id);
+
+public slots:
+    void start();
+    void cancel();
+
+private slots:
+    void imageDecoded(const QImage &image);
+    void fetchFailed(int id);
+
+private:
+    void decode();
+    void finish(const QString &error = QString());
+
+    QString m_image;
+    int m_cacheId;
+    QSize m_requestedSize;
+    int m_jobId;
+    bool m_fetched;
+    bool m_finished;
+    QImage m_result;
+    QString m_error;
+};
+#endif
+
+#endif // IMAGEPROVIDER_H
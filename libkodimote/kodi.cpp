@@ -25,6 +25,7 @@
 #include "kodebug.h"
 #include "kodidiscovery.h"
 #include "kodidownload.h"
+#include "kodidownloadjob.h"
 
 #include "audiolibrary.h"
 #include "artists.h"
@@ -56,6 +57,10 @@
 #include "settings.h"
 
 #include "imagecache.h"
+#include "detailscache.h"
+#include "entitystore.h"
+#include "modelcache.h"
+#include "artworkwarmup.h"
 
 
 #ifdef QT5_BUILD
@@ -85,6 +90,10 @@ Kodi::Kodi(QObject *parent) :
     m_pvrRecording(false),
     m_pvrScanning(false),
     m_imageCache(new KodiImageCache(this)),
+    m_detailsCache(new KodiDetailsCache(this)),
+    m_entityStore(new KodiEntityStore(this)),
+    m_modelCache(new KodiModelCache(this)),
+    m_artworkWarmup(new KodiArtworkWarmup(this)),
     m_dataPath(QDir::home().absolutePath() + "/.kodimote/")
 {
 
@@ -157,6 +166,8 @@ Kodi::Kodi(QObject *parent) :
     qmlRegisterType<Profiles>();
     qmlRegisterType<Keys>();
     qmlRegisterType<EventClient>();
+    qmlRegisterType<KodiArtworkWarmup>();
+    qmlRegisterType<KodiDownloadJob>();
     qmlRegisterType<KodiFilterModel>(qmlUri, 1, 0, "KodiFilterModel");
 
     // Hack: QML seems to have problems with enums exposed by a qmlRegisterUncreatableType
@@ -177,6 +188,7 @@ Kodi::Kodi(QObject *parent) :
     connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(parseAnnouncement(QVariantMap)));
     connect(KodiConnection::notifier(), SIGNAL(authenticationRequired(QString,QString)), SIGNAL(authenticationRequired(QString, QString)));
     connect(KodiConnection::notifier(), SIGNAL(downloadAdded(KodiDownload*)), SLOT(slotDownloadAdded(KodiDownload*)));
+    connect(KodiConnection::notifier(), SIGNAL(downloadJobAdded(KodiDownloadJob*)), SIGNAL(downloadJobAdded(KodiDownloadJob*)));
 
     m_audioPlayer = new AudioPlayer(this);
     m_videoPlayer = new VideoPlayer(this);
@@ -238,9 +250,15 @@ void Kodi::init()
 void Kodi::slotDownloadAdded(KodiDownload *download)
 {
     connect(download, SIGNAL(finished(bool)), SLOT(downloadFinished(bool)));
+    connect(download, SIGNAL(speedChanged()), SIGNAL(downloadSpeedChanged()));
     emit downloadAdded(download);
 }
 
+qint64 Kodi::downloadSpeed() const
+{
+    return KodiConnection::downloadSpeed();
+}
+
 void Kodi::downloadFinished(bool success)
 {
     KodiDownload *download = qobject_cast<KodiDownload*>(sender());
@@ -663,6 +681,26 @@ KodiImageCache *Kodi::imageCache()
     return m_imageCache;
 }
 
+KodiDetailsCache *Kodi::detailsCache()
+{
+    return m_detailsCache;
+}
+
+KodiEntityStore *Kodi::entityStore()
+{
+    return m_entityStore;
+}
+
+KodiModelCache *Kodi::modelCache()
+{
+    return m_modelCache;
+}
+
+KodiArtworkWarmup *Kodi::artworkWarmup()
+{
+    return m_artworkWarmup;
+}
+
 QString Kodi::dataPath() const
 {
     return m_dataPath;
@@ -44,8 +44,13 @@ class Keys;
 class EventClient;
 
 class KodiDownload;
+class KodiDownloadJob;
 
 class KodiImageCache;
+class KodiDetailsCache;
+class KodiEntityStore;
+class KodiModelCache;
+class KodiArtworkWarmup;
 
 class Kodi : public QObject
 {
@@ -73,6 +78,8 @@ class Kodi : public QObject
     Q_PROPERTY(bool pvrRecording READ pvrRecording NOTIFY pvrRecordingChanged)
     Q_PROPERTY(bool pvrScanning READ pvrScanning NOTIFY pvrScanningChanged)
 
+    Q_PROPERTY(qint64 downloadSpeed READ downloadSpeed NOTIFY downloadSpeedChanged)
+
 public:
     enum GuiWindow {
         GuiWindowHome,
@@ -136,7 +143,14 @@ public:
     bool pvrRecording();
     bool pvrScanning();
 
+    // Combined transfer rate of all running downloads in bytes per second
+    qint64 downloadSpeed() const;
+
     KodiImageCache *imageCache();
+    KodiDetailsCache *detailsCache();
+    KodiEntityStore *entityStore();
+    KodiModelCache *modelCache();
+    Q_INVOKABLE KodiArtworkWarmup *artworkWarmup();
 
     QString dataPath() const;
     void setDataPath(const QString &path);
@@ -166,6 +180,8 @@ signals:
     void systemPropertiesChanged();
 
     void downloadAdded(KodiDownload* download);
+    void downloadJobAdded(KodiDownloadJob* job);
+    void downloadSpeedChanged();
 
     void displayNotification(const QString &text);
 
@@ -228,6 +244,10 @@ private:
     bool m_pvrScanning;
 
     KodiImageCache *m_imageCache;
+    KodiDetailsCache *m_detailsCache;
+    KodiEntityStore *m_entityStore;
+    KodiModelCache *m_modelCache;
+    KodiArtworkWarmup *m_artworkWarmup;
     QString m_dataPath;
 };
 
@@ -23,6 +23,7 @@
 
 #include "kodebug.h"
 #include "kodidownload.h"
+#include "settings.h"
 
 #ifdef QT5_BUILD
 #include <QJsonDocument>
@@ -38,6 +39,9 @@
 #include <QAuthenticator>
 #include <QHostInfo>
 #include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QCryptographicHash>
 
 #define DEBUGJSON
 
@@ -118,6 +122,40 @@ void download(KodiDownload *download)
     instance()->download(download);
 }
 
+void addDownloadJob(KodiDownloadJob *job)
+{
+    emit instance()->notifier()->downloadJobAdded(job);
+}
+
+qint64 downloadSpeed()
+{
+    return instance()->downloadSpeed();
+}
+
+// Downloads running at once over all hosts
+static const int maxActiveDownloads = 8;
+// Connections used for a single file at most
+static const int maxSegments = 4;
+// Files are only split if each part gets at least this much
+static const qint64 minSegmentSize = 32 * 1024 * 1024;
+// How long to measure the throughput before trying another segment
+static const int segmentTuningInterval = 3000;
+// Data a reply may hold before the network access manager stops reading from the
+// socket. Keeps memory bounded when the disk is slower than the network.
+static const qint64 downloadReadBufferSize = 1024 * 1024;
+// Data is written in chunks of this size, at offsets aligned to it
+static const qint64 downloadWriteChunkSize = 256 * 1024;
+// Downloads are throttled when commands take longer than this (ms) to be answered
+static const qint64 commandLatencyThreshold = 300;
+// How often command latency is probed while downloads are running (ms)
+static const int latencyProbeInterval = 1000;
+// A probe that got no answer within this time (ms) is given up on
+static const qint64 latencyProbeTimeout = 5000;
+// Throttled downloads never go slower than this (bytes/s)
+static const qint64 minDownloadRate = 64 * 1024;
+// How often the download token bucket is refilled (ms)
+static const int shapingInterval = 100;
+
 /*****************************************************************
   Private impl
   ***************************************************************/
@@ -132,7 +170,11 @@ KodiConnectionPrivate::KodiConnectionPrivate(QObject *parent) :
     m_connecting(false),
     m_connected(false),
     m_disconnecting(false),
-    m_networkSession(0)
+    m_networkSession(0),
+    m_downloadRate(0),
+    m_downloadTokens(0),
+    m_shapingRound(0),
+    m_latencyProbeId(-1)
 {
     m_socket = new QTcpSocket();
     m_notifier = new KodiConnection::Notifier();
@@ -151,6 +193,11 @@ KodiConnectionPrivate::KodiConnectionPrivate(QObject *parent) :
 
     m_network = new QNetworkAccessManager();
     QObject::connect(m_network, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)), SLOT(authenticationRequired(QNetworkReply*,QAuthenticator*)));
+    m_downloadNetwork = new QNetworkAccessManager();
+    QObject::connect(m_downloadNetwork, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)), SLOT(authenticationRequired(QNetworkReply*,QAuthenticator*)));
+
+    m_shapingTimer.setInterval(shapingInterval);
+    QObject::connect(&m_shapingTimer, SIGNAL(timeout()), SLOT(refillDownloadTokens()));
 
     m_reconnectTimer.setInterval(5000);
     m_reconnectTimer.setSingleShot(true);
@@ -294,6 +341,10 @@ void KodiConnectionPrivate::versionReceived(const QVariantMap &rsp)
     m_connecting = false;
     emit m_notifier->connectionChanged();
     m_host->setPersistent(true);
+
+    if(m_connected) {
+        restoreDownloads();
+    }
 }
 
 void KodiConnectionPrivate::slotDisconnected()
@@ -553,73 +604,568 @@ Notifier *KodiConnectionPrivate::notifier()
 void KodiConnectionPrivate::download(KodiDownload *download)
 {
     qDebug() << "added download:" << download->source() << "-->" << download->destination();
+    if(download->hostId().isEmpty() && m_host) {
+        download->setHostId(m_host->id().toString());
+    }
+    QObject::connect(download, SIGNAL(cancelled()), SLOT(cancelDownload()));
+    storeDownload(download);
     m_downloadQueue.append(download);
     emit m_notifier->downloadAdded(download);
     downloadNext();
 }
 
+/*
+ * Queued and unfinished downloads are kept in the settings, grouped by host,
+ * so they can be picked up again from their partial file on the next connection.
+ */
+static QString downloadKey(KodiDownload *download)
+{
+    return QCryptographicHash::hash(download->destination().toUtf8(), QCryptographicHash::Md5).toHex();
+}
+
+void KodiConnectionPrivate::storeDownload(KodiDownload *download)
+{
+    // Ranges still missing from a segmented download, as "start-end"
+    QStringList segments;
+    QList<DownloadSegment> missing = m_failedSegments.value(download);
+    foreach(QNetworkReply *reply, m_activeDownloadsMap.keys(download)) {
+        if(m_segments.contains(reply)) {
+            missing.append(m_segments.value(reply));
+        }
+    }
+    foreach(const DownloadSegment &segment, missing) {
+        segments.append(QString::number(segment.position) + '-' + QString::number(segment.end));
+    }
+
+    QSettings settings;
+    settings.beginGroup("Downloads");
+    settings.beginGroup(download->hostId());
+    settings.beginGroup(downloadKey(download));
+    settings.setValue("Source", download->source());
+    settings.setValue("Destination", download->destination());
+    settings.setValue("Label", download->label());
+    settings.setValue("IconId", download->iconId());
+    settings.setValue("Batch", download->batch());
+    settings.setValue("Total", download->total());
+    settings.setValue("Segmented", download->segmented());
+    settings.setValue("Segments", segments);
+}
+
+void KodiConnectionPrivate::forgetDownload(KodiDownload *download)
+{
+    QSettings settings;
+    settings.beginGroup("Downloads");
+    settings.beginGroup(download->hostId());
+    settings.remove(downloadKey(download));
+}
+
+void KodiConnectionPrivate::restoreDownloads()
+{
+    QStringList destinations;
+    foreach(KodiDownload *download, m_downloadQueue + m_activeDownloadsMap.values()) {
+        destinations.append(download->destination());
+    }
+
+    QSettings settings;
+    settings.beginGroup("Downloads");
+    settings.beginGroup(m_host->id().toString());
+    foreach(const QString &key, settings.childGroups()) {
+        settings.beginGroup(key);
+        QString destination = settings.value("Destination").toString();
+        if(!destinations.contains(destination)) {
+            KodiDownload *download = new KodiDownload();
+            download->setHostId(m_host->id().toString());
+            download->setSource(settings.value("Source").toString());
+            download->setDestination(destination);
+            download->setLabel(settings.value("Label").toString());
+            download->setIconId(settings.value("IconId").toString());
+            download->setBatch(settings.value("Batch").toInt());
+            download->setTotal(settings.value("Total").toLongLong());
+            download->setSegmented(settings.value("Segmented").toBool());
+            download->setProgress(QFileInfo(download->partialFile()).size());
+
+            QList<DownloadSegment> segments;
+            qint64 missing = 0;
+            foreach(const QString &range, settings.value("Segments").toStringList()) {
+                DownloadSegment segment;
+                segment.position = range.section('-', 0, 0).toLongLong();
+                segment.end = range.section('-', 1, 1).toLongLong();
+                segments.append(segment);
+                missing += segment.end - segment.position;
+            }
+            if(!segments.isEmpty()) {
+                m_pendingSegments.insert(download, segments);
+                download->setProgress(download->total() - missing);
+            }
+
+            qDebug() << "restoring download" << download->source() << "at" << download->progress();
+            QObject::connect(download, SIGNAL(cancelled()), SLOT(cancelDownload()));
+            m_downloadQueue.append(download);
+            emit m_notifier->downloadAdded(download);
+        }
+        settings.endGroup();
+    }
+    downloadNext();
+}
+
+qint64 KodiConnectionPrivate::downloadSpeed() const
+{
+    qint64 speed = 0;
+    foreach(KodiDownload *download, m_activeDownloadsMap.values().toSet()) {
+        speed += download->speed();
+    }
+    return speed;
+}
+
+int KodiConnectionPrivate::activeDownloads(const QString &hostId) const
+{
+    // One per transfer, a segmented download counts for each of its connections
+    int count = 0;
+    foreach(KodiDownload *download, m_activeDownloadsMap) {
+        if(download->hostId() == hostId) {
+            count++;
+        }
+    }
+    return count;
+}
+
+KodiDownload *KodiConnectionPrivate::nextDownload() const
+{
+    // Pick the oldest download of the batch with the fewest transfers running
+    KodiDownload *next = 0;
+    int nextActive = 0;
+    foreach(KodiDownload *download, m_downloadQueue) {
+        if(download->hostId() != m_host->id().toString()) {
+            // Queued for another host, wait until we're connected to it again
+            continue;
+        }
+        int active = 0;
+        foreach(KodiDownload *activeDownload, m_activeDownloadsMap) {
+            if(activeDownload->batch() == download->batch()) {
+                active++;
+            }
+        }
+        if(!next || active < nextActive) {
+            next = download;
+            nextActive = active;
+        }
+    }
+    return next;
+}
+
+int KodiConnectionPrivate::maxDownloadsPerHost() const
+{
+    // Each host gets a few parallel transfers. The download network access manager
+    // opens at most 6 connections per host, more would just queue up in there.
+    return qBound(1, Settings().parallelDownloads(), 6);
+}
+
 void KodiConnectionPrivate::downloadNext()
 {
-    if(!m_activeDownloadsMap.isEmpty()) {
-        qDebug() << "Download in progress... not starting next one";
+    if(!m_connected) {
         return;
     }
-    if(m_downloadQueue.isEmpty()) {
-        qDebug() << "Download queue empty";
-        return;
+    QString hostId = m_host->id().toString();
+    int maxPerHost = maxDownloadsPerHost();
+
+    while(m_activeDownloadsMap.count() < maxActiveDownloads && activeDownloads(hostId) < maxPerHost) {
+        KodiDownload *download = nextDownload();
+        if(!download) {
+            qDebug() << "Download queue empty";
+            return;
+        }
+        m_downloadQueue.removeOne(download);
+        startDownload(download);
     }
-    KodiDownload *download = m_downloadQueue.takeFirst();
-    qDebug() << "Starting download:" << download->source() << "-->" << download->destination();
-    QByteArray url = QUrl::toPercentEncoding("http://" + KodiConnection::connectedHost()->address() + ':' + QString::number(KodiConnection::connectedHost()->port()) + '/');
+}
+
+QNetworkRequest KodiConnectionPrivate::downloadRequest(KodiDownload *download) const
+{
+    QByteArray url = QUrl::toPercentEncoding("http://" + m_host->address() + ':' + QString::number(m_host->port()) + '/');
     url.append(download->source().toUtf8());
     QNetworkRequest request;
     request.setUrl(QUrl::fromPercentEncoding(url));
-    qDebug() << "getting:" << request.url();
+    return request;
+}
+
+QNetworkReply *KodiConnectionPrivate::getDownload(KodiDownload *download, const QNetworkRequest &request)
+{
+    qDebug() << "getting:" << request.url() << request.rawHeader("Range");
+    QNetworkReply *reply = m_downloadNetwork->get(request);
+    reply->setReadBufferSize(downloadReadBufferSize);
+    if(!m_shapingTimer.isActive()) {
+        m_shapingTimer.start();
+    }
+    QObject::connect(reply, SIGNAL(metaDataChanged()), SLOT(downloadMetaDataChanged()));
+    QObject::connect(reply, SIGNAL(readyRead()), SLOT(downloadReadyRead()));
+    QObject::connect(reply, SIGNAL(downloadProgress(qint64,qint64)), SLOT(downloadProgress(qint64,qint64)));
+    QObject::connect(reply, SIGNAL(finished()), SLOT(downloadFinished()));
+    m_activeDownloadsMap.insert(reply, download);
+    return reply;
+}
 
-    QFile *file = new QFile(download->destination());
+void KodiConnectionPrivate::startDownload(KodiDownload *download)
+{
+    qDebug() << "Starting download:" << download->source() << "-->" << download->destination();
+    QNetworkRequest request = downloadRequest(download);
+
+    QFile *file = new QFile(download->partialFile());
     QFileInfo fi(download->destination());
 
     if(!fi.dir().exists()) {
         if(!fi.dir().mkpath(fi.dir().absolutePath())) {
             qDebug() << "cannot create dir" << fi.dir().absolutePath();
+            forgetDownload(download);
             download->setFinished(false);
             download->deleteLater();
             delete file;
             return;
         }
     }
-    if(!file->open(QIODevice::ReadWrite)) {
-        qDebug() << "cannot open destination" << download->destination();
+
+    // A segmented download was interrupted. The file is preallocated, fetch what's missing.
+    QList<DownloadSegment> segments = m_pendingSegments.take(download);
+    if(!segments.isEmpty() && download->total() > 0 && file->size() == download->total() && file->open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        qDebug() << "resuming" << segments.count() << "segments";
+        download->setFile(file);
+        download->setStarted();
+        SegmentTuning tuning;
+        tuning.done = !download->segmented();
+        m_segmentTuning.insert(download, tuning);
+        foreach(const DownloadSegment &segment, segments) {
+            startSegment(download, segment);
+        }
+        return;
+    }
+
+    if(!file->open(QIODevice::ReadWrite | QIODevice::Append)) {
+        qDebug() << "cannot open destination" << download->partialFile();
+        forgetDownload(download);
         download->setFinished(false);
         download->deleteLater();
         delete file;
         return;
     }
 
-    QNetworkReply *reply = m_network->get(request);
-    QObject::connect(reply, SIGNAL(readyRead()), SLOT(downloadReadyRead()));
-    QObject::connect(reply, SIGNAL(downloadProgress(qint64,qint64)), SLOT(downloadProgress(qint64,qint64)));
-    QObject::connect(reply, SIGNAL(finished()), SLOT(downloadFinished()));
-    QObject::connect(download, SIGNAL(cancelled()), SLOT(cancelDownload()));
-    qDebug() << reply->errorString();
+    // Continue where an earlier attempt stopped
+    download->setOffset(file->size());
+    if(download->total() > 0 && download->offset() >= download->total()) {
+        // Preallocated by a segmented download we lost track of
+        file->resize(0);
+        download->setOffset(0);
+    }
+    if(download->offset() > 0) {
+        qDebug() << "resuming download at" << download->offset();
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(download->offset()) + '-');
+    }
 
     download->setFile(file);
     download->setStarted();
-    m_activeDownloadsMap.insert(reply,download);
+    getDownload(download, request);
+}
+
+void KodiConnectionPrivate::startSegment(KodiDownload *download, const DownloadSegment &segment)
+{
+    QNetworkRequest request = downloadRequest(download);
+    request.setRawHeader("Range", "bytes=" + QByteArray::number(segment.position) + '-' + QByteArray::number(segment.end - 1));
+    QNetworkReply *reply = getDownload(download, request);
+    m_segments.insert(reply, segment);
+}
+
+bool KodiConnectionPrivate::splitSegment(KodiDownload *download)
+{
+    // Halve the segment with the most data left and fetch its second half on a new connection
+    QNetworkReply *largest = 0;
+    foreach(QNetworkReply *reply, m_activeDownloadsMap.keys(download)) {
+        if(m_segments.contains(reply) && (!largest || m_segments.value(reply).remaining() > m_segments.value(largest).remaining())) {
+            largest = reply;
+        }
+    }
+    if(!largest || m_segments.value(largest).unread() < 2 * minSegmentSize) {
+        return false;
+    }
+
+    DownloadSegment &segment = m_segments[largest];
+    DownloadSegment second;
+    second.position = segment.end - segment.unread() / 2;
+    second.end = segment.end;
+    segment.end = second.position;
+    qDebug() << "splitting download" << download->label() << "at" << second.position;
+    startSegment(download, second);
+    storeDownload(download);
+    return true;
+}
+
+void KodiConnectionPrivate::tuneSegments(KodiDownload *download)
+{
+    SegmentTuning &tuning = m_segmentTuning[download];
+    if(!tuning.timer.isValid()) {
+        tuning.timer.start();
+        return;
+    }
+    if(tuning.timer.elapsed() < segmentTuningInterval) {
+        return;
+    }
+    tuning.timer.restart();
+
+    // Keep the stored ranges reasonably fresh in case we get killed
+    storeDownload(download);
+
+    if(tuning.done) {
+        return;
+    }
+    // Add connections as long as each one still makes things noticeably faster.
+    // A single stream is often limited by the server well below the link speed.
+    qint64 speed = download->speed();
+    if(speed > tuning.lastSpeed * 5 / 4
+            && m_activeDownloadsMap.keys(download).count() < maxSegments
+            && activeDownloads(download->hostId()) < maxDownloadsPerHost()
+            && splitSegment(download)) {
+        tuning.lastSpeed = speed;
+    } else {
+        qDebug() << "download" << download->label() << "settled on" << m_activeDownloadsMap.keys(download).count() << "segments at" << speed << "bytes/s";
+        tuning.done = true;
+    }
+}
+
+bool KodiConnectionPrivate::writeSegment(QFile *file, DownloadSegment &segment, bool flush)
+{
+    qint64 size = segment.pending.size();
+    if(!flush) {
+        // Only write up to the last chunk boundary we have data for
+        size = (segment.position + size) / downloadWriteChunkSize * downloadWriteChunkSize - segment.position;
+        if(segment.pending.size() < downloadWriteChunkSize || size <= 0) {
+            return true;
+        }
+    }
+    if(size == 0) {
+        return true;
+    }
+    if(!file->seek(segment.position) || file->write(segment.pending.constData(), size) != size) {
+        qDebug() << "cannot write download" << file->errorString();
+        return false;
+    }
+    segment.pending.remove(0, size);
+    segment.position += size;
+    return true;
 }
 
 void KodiConnectionPrivate::downloadReadyRead()
 {
-    QNetworkReply *reply = static_cast<QNetworkReply*>(sender());
+    readDownload(static_cast<QNetworkReply*>(sender()));
+}
+
+void KodiConnectionPrivate::readDownload(QNetworkReply *reply)
+{
     KodiDownload *download = m_activeDownloadsMap.value(reply);
+    if(!download) {
+        return;
+    }
     QFile *file = download->file();
-    if(file->write(reply->readAll()) == -1) {
-        reply->abort();
-        reply->deleteLater();
-        download->setFinished(false);
-        download->deleteLater();
+
+    // Whatever we leave in the reply stays in its bounded read buffer. Once that
+    // is full the network access manager stops reading and TCP slows the sender down.
+    qint64 allowed = m_downloadRate > 0 ? m_downloadTokens : reply->bytesAvailable();
+    if(allowed <= 0) {
+        return;
+    }
+
+    if(m_segments.contains(reply)) {
+        DownloadSegment &segment = m_segments[reply];
+        download->setBufferedBytes(reply->bytesAvailable() + segment.pending.size());
+        QByteArray data = reply->read(qMin(segment.unread(), allowed));
+        m_downloadTokens -= data.size();
+        segment.pending.append(data);
+        bool complete = segment.unread() == 0;
+        if(complete) {
+            // Split segments keep receiving data past their new end, drop it
+            reply->readAll();
+        }
+        if(!writeSegment(file, segment, complete)) {
+            m_brokenDownloads.insert(download);
+            foreach(QNetworkReply *segmentReply, m_activeDownloadsMap.keys(download)) {
+                segmentReply->abort();
+            }
+            return;
+        }
+        if(complete) {
+            reply->abort();
+        }
+        return;
+    }
+
+    download->setBufferedBytes(reply->bytesAvailable());
+    QByteArray data = reply->read(allowed);
+    m_downloadTokens -= data.size();
+    if(file->write(data) == -1) {
         file->remove(); // Try to delete the broken file
-        delete file;
+        // downloadFinished() cleans up and reports the failure
+        reply->abort();
+    }
+}
+
+void KodiConnectionPrivate::setDownloadRate(qint64 rate)
+{
+    if(m_downloadRate == 0 && rate > 0) {
+        // Tokens weren't counted while unlimited
+        m_downloadTokens = 0;
+    }
+    if(rate == m_downloadRate) {
+        return;
+    }
+    koDebug(XDAREA_CONNECTION) << "download rate" << rate;
+    bool unthrottled = m_downloadRate > 0 && rate == 0;
+    m_downloadRate = rate;
+
+    if(unthrottled) {
+        // Replies holding a full buffer won't get another readyRead, drain them now
+        foreach(QNetworkReply *reply, m_activeDownloadsMap.keys()) {
+            readDownload(reply);
+        }
+    }
+}
+
+void KodiConnectionPrivate::updateDownloadRate(qint64 commandLatency)
+{
+    if(m_activeDownloadsMap.isEmpty()) {
+        return;
+    }
+
+    qint64 limit = m_host ? m_host->downloadRateLimit() * 1024 : 0;
+    if(commandLatency > commandLatencyThreshold) {
+        // Commands are stuck behind download traffic, halve what downloads currently get
+        qint64 current = m_downloadRate > 0 ? m_downloadRate : downloadSpeed();
+        setDownloadRate(qMax(minDownloadRate, current / 2));
+    } else if(commandLatency < commandLatencyThreshold / 2 && m_downloadRate > 0) {
+        // Responsive again, carefully give downloads more
+        qint64 rate = m_downloadRate + m_downloadRate / 8;
+        if(limit > 0) {
+            rate = qMin(rate, limit);
+        } else if(rate > downloadSpeed() * 2) {
+            // The limit isn't what's holding downloads back anymore
+            rate = 0;
+        }
+        setDownloadRate(rate);
+    }
+}
+
+void KodiConnectionPrivate::probeLatency()
+{
+    if(m_latencyProbeId >= 0) {
+        if(m_latencyProbeTimer.elapsed() < latencyProbeTimeout) {
+            // Still waiting for the last one
+            return;
+        }
+        // Lost or stuck behind the downloads, either way it counts as slow
+        updateDownloadRate(m_latencyProbeTimer.elapsed());
+    }
+    // A ping costs Kodi next to nothing, so the round trip is what the connection adds
+    m_latencyProbeTimer.start();
+    m_latencyProbeId = sendParallelCommand("JSONRPC.Ping", QVariant(), this, "latencyProbeReceived");
+}
+
+void KodiConnectionPrivate::latencyProbeReceived(const QVariantMap &rsp)
+{
+    if(rsp.value("id").toInt() != m_latencyProbeId) {
+        return;
+    }
+    m_latencyProbeId = -1;
+    updateDownloadRate(m_latencyProbeTimer.elapsed());
+}
+
+void KodiConnectionPrivate::refillDownloadTokens()
+{
+    if(m_activeDownloadsMap.isEmpty()) {
+        m_shapingTimer.stop();
+        m_latencyProbeId = -1;
+        setDownloadRate(0);
+        return;
+    }
+
+    m_shapingRound++;
+    if(m_shapingRound % (latencyProbeInterval / shapingInterval) == 0) {
+        probeLatency();
+    }
+
+    qint64 limit = m_host ? m_host->downloadRateLimit() * 1024 : 0;
+    if(limit > 0 && (m_downloadRate == 0 || m_downloadRate > limit)) {
+        setDownloadRate(limit);
+    }
+    if(m_downloadRate == 0) {
+        // Unlimited, replies are read as soon as data arrives
+        return;
+    }
+
+    // Don't let tokens pile up beyond a couple of intervals, that would allow long bursts
+    qint64 refill = m_downloadRate * shapingInterval / 1000;
+    m_downloadTokens = qMin(m_downloadTokens + refill, refill * 2);
+
+    // Take turns on which reply gets served first
+    QList<QNetworkReply*> replies = m_activeDownloadsMap.keys();
+    for(int i = 0; i < replies.count() && m_downloadTokens > 0; ++i) {
+        readDownload(replies.at((m_shapingRound + i) % replies.count()));
+    }
+}
+
+void KodiConnectionPrivate::downloadMetaDataChanged()
+{
+    QNetworkReply *reply = static_cast<QNetworkReply*>(sender());
+    KodiDownload *download = m_activeDownloadsMap.value(reply);
+    if(!download || reply->error() != QNetworkReply::NoError) {
+        return;
+    }
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    if(m_segments.contains(reply)) {
+        if(status != 206) {
+            qDebug() << "server refused range request for segment";
+            reply->abort();
+        }
+        return;
+    }
+
+    if(download->offset() > 0 && status != 206) {
+        // The server ignored the Range header and sends the whole file
+        qDebug() << "cannot resume download, starting over";
+        download->file()->resize(0);
+        download->setOffset(0);
+    }
+
+    qint64 total = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+    if(total > 0) {
+        download->setTotal(download->offset() + total);
+
+        if(download->skipExisting() && QFileInfo(download->destination()).size() == download->total()) {
+            qDebug() << "already downloaded" << download->destination();
+            m_skippedDownloads.insert(download);
+            reply->abort();
+            return;
+        }
+
+        storeDownload(download);
+
+        // Preallocate the whole file and write at explicit offsets from now on. Avoids
+        // fragmenting the file on slow flash storage, makes sure there's enough space
+        // before we fetch anything and lets segments write to their own ranges.
+        QFile *file = download->file();
+        file->close();
+        if(!file->open(QIODevice::ReadWrite | QIODevice::Unbuffered) || !file->resize(download->total())) {
+            qDebug() << "cannot preallocate" << download->partialFile();
+            file->close();
+            file->open(QIODevice::ReadWrite | QIODevice::Append);
+            file->resize(download->offset());
+            return;
+        }
+        DownloadSegment segment;
+        segment.position = download->offset();
+        segment.end = download->total();
+        m_segments.insert(reply, segment);
+
+        bool rangesSupported = status == 206 || reply->rawHeader("Accept-Ranges") == "bytes";
+        SegmentTuning tuning;
+        tuning.done = !download->segmented() || !rangesSupported || total < 2 * minSegmentSize;
+        m_segmentTuning.insert(download, tuning);
+        storeDownload(download);
     }
 }
 
@@ -627,43 +1173,136 @@ void KodiConnectionPrivate::downloadProgress(qint64 progress, qint64 total)
 {
     QNetworkReply *reply = static_cast<QNetworkReply*>(sender());
     KodiDownload *download = m_activeDownloadsMap.value(reply);
-    download->setTotal(total);
-    download->setProgress(progress);
+    if(!download) {
+        return;
+    }
+
+    if(m_segmentTuning.contains(download)) {
+        qint64 missing = 0;
+        foreach(const DownloadSegment &segment, m_failedSegments.value(download)) {
+            missing += segment.remaining();
+        }
+        foreach(QNetworkReply *segmentReply, m_activeDownloadsMap.keys(download)) {
+            missing += m_segments.value(segmentReply).remaining();
+        }
+        download->setProgress(download->total() - missing);
+        tuneSegments(download);
+        return;
+    }
+
+    if(total >= 0) {
+        download->setTotal(download->offset() + total);
+    }
+    download->setProgress(download->offset() + progress);
 }
 
 void KodiConnectionPrivate::cancelDownload()
 {
     KodiDownload *download = static_cast<KodiDownload*>(sender());
-    QNetworkReply *reply = m_activeDownloadsMap.key(download);
-    if(reply) {
-        reply->close();
+    QList<QNetworkReply*> replies = m_activeDownloadsMap.keys(download);
+    if(!replies.isEmpty()) {
+        foreach(QNetworkReply *reply, replies) {
+            reply->close();
+        }
+    } else if(m_downloadQueue.removeOne(download)) {
+        forgetDownload(download);
+        m_pendingSegments.remove(download);
+        QFile::remove(download->partialFile());
+        download->setFinished(false);
+        download->deleteLater();
     }
 }
 
+static bool resumable(QNetworkReply::NetworkError error)
+{
+    // Connection problems, as opposed to HTTP errors or being cancelled
+    return error != QNetworkReply::OperationCanceledError && error < QNetworkReply::ProxyConnectionRefusedError;
+}
+
 void KodiConnectionPrivate::downloadFinished()
 {
     QNetworkReply *reply = static_cast<QNetworkReply*>(sender());
     KodiDownload *download = m_activeDownloadsMap.value(reply);
+    reply->deleteLater();
 
     QFile *file = download->file();
+    bool segmented = m_segmentTuning.contains(download);
+    QNetworkReply::NetworkError error = reply->error();
+
+    if(m_segments.contains(reply)) {
+        DownloadSegment segment = m_segments.take(reply);
+        m_activeDownloadsMap.remove(reply);
+        // Whatever arrived is valid data even if the segment is incomplete
+        segment.pending.append(reply->read(segment.unread()));
+        if(!writeSegment(file, segment, true)) {
+            m_brokenDownloads.insert(download);
+        }
+        if(m_brokenDownloads.contains(download)) {
+            // Already failed
+        } else if(segment.remaining() == 0) {
+            // We abort segments ourselves once they are complete
+            error = QNetworkReply::NoError;
+        } else if(resumable(error)) {
+            m_failedSegments[download].append(segment);
+        } else {
+            m_brokenDownloads.insert(download);
+        }
+        if(!m_activeDownloadsMap.keys(download).isEmpty()) {
+            // Other segments are still running
+            downloadNext();
+            return;
+        }
+        if(!m_brokenDownloads.contains(download) && m_failedSegments.contains(download)) {
+            // Report the interruption rather than the last segment's result
+            error = QNetworkReply::RemoteHostClosedError;
+        }
+    } else {
+        m_activeDownloadsMap.remove(reply);
+        file->write(reply->readAll());
+    }
+
+    bool skipped = m_skippedDownloads.remove(download);
+    if(skipped) {
+        error = QNetworkReply::NoError;
+    } else if(m_brokenDownloads.remove(download)) {
+        error = QNetworkReply::OperationCanceledError;
+    }
     download->setFile(0);
 
-    file->write(reply->readAll());
+    if(!skipped && error == QNetworkReply::NoError && download->total() > 0 && file->size() != download->total()) {
+        qDebug() << "download size mismatch" << file->size() << "expected" << download->total();
+        error = QNetworkReply::UnknownContentError;
+    }
     file->close();
-    delete file;
 
-    if(reply->error() == QNetworkReply::NoError) {
+    if(skipped) {
+        file->remove();
+        forgetDownload(download);
+        download->setFinished(true);
+    } else if(error == QNetworkReply::NoError) {
         qDebug() << "download finished";
+        QFile::remove(download->destination());
+        file->rename(download->destination());
+        forgetDownload(download);
         download->setFinished(true);
+    } else if(resumable(error)) {
+        // Connection problem. Keep the partial file and resume on the next connection
+        qDebug() << "download interrupted" << error << reply->errorString();
+        if(segmented) {
+            storeDownload(download);
+        }
+        download->setFinished(false);
     } else {
-        qDebug() << "download failed" << reply->error() << reply->errorString();
+        qDebug() << "download failed" << error << reply->errorString();
+        file->remove();
+        forgetDownload(download);
         download->setFinished(false);
     }
+    delete file;
+    m_failedSegments.remove(download);
+    m_segmentTuning.remove(download);
     download->deleteLater();
 
-    m_activeDownloadsMap.remove(reply);
-    reply->deleteLater();
-
     downloadNext();
 }
 
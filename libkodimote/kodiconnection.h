@@ -27,6 +27,7 @@
 
 class KodiHost;
 class KodiDownload;
+class KodiDownloadJob;
 
 namespace KodiConnection
 {
@@ -50,6 +51,8 @@ int sendParallelCommand(const QString &command, const QVariant &params, QObject
 QNetworkAccessManager *nam();
 
 void download(KodiDownload *download);
+void addDownloadJob(KodiDownloadJob *job);
+qint64 downloadSpeed();
 
 class Notifier: public QObject
 {
@@ -61,6 +64,7 @@ signals:
     void receivedAnnouncement(const QVariantMap &announcement);
     void authenticationRequired(const QString &hostname, const QString &address);
     void downloadAdded(KodiDownload *download);
+    void downloadJobAdded(KodiDownloadJob *job);
 };
 Notifier *notifier();
 }
@@ -35,6 +35,10 @@
 #include <QPointer>
 #include <QNetworkConfigurationManager>
 #include <QNetworkSession>
+#include <QNetworkRequest>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
 
 class KodiDownload;
 
@@ -75,6 +79,34 @@ private:
     QString m_member;
 };
 
+/**
+  * A byte range of a file downloaded over its own connection.
+  * "position" is the next byte to be written, "end" is exclusive.
+  * Received data is collected in "pending" until it's worth a write.
+  */
+class DownloadSegment
+{
+public:
+    DownloadSegment(): position(0), end(0) {}
+
+    qint64 remaining() const { return end - position; }
+    qint64 unread() const { return end - position - pending.size(); }
+
+    qint64 position;
+    qint64 end;
+    QByteArray pending;
+};
+
+class SegmentTuning
+{
+public:
+    SegmentTuning(): lastSpeed(0), done(false) { timer.invalidate(); }
+
+    QElapsedTimer timer;
+    qint64 lastSpeed;
+    bool done;
+};
+
 class KodiConnectionPrivate : public QObject
 {
     Q_OBJECT
@@ -99,6 +131,7 @@ public:
     Notifier *notifier();
 
     void download(KodiDownload *download);
+    qint64 downloadSpeed() const;
 
 public slots:
     void connect(KodiHost *host = 0);
@@ -123,6 +156,9 @@ private slots:
     void downloadReadyRead();
     void downloadFinished();
     void downloadProgress(qint64 progress, qint64 total);
+    void downloadMetaDataChanged();
+    void refillDownloadTokens();
+    void latencyProbeReceived(const QVariantMap &rsp);
 
     void cancelDownload();
 
@@ -145,10 +181,29 @@ private:
     void closeConnection(bool reconnect = true);
     QByteArray buildJsonPayload(const Command &command);
     QByteArray sendRequest(const Command &command);
+    void startDownload(KodiDownload *download);
+    int maxDownloadsPerHost() const;
+    QNetworkRequest downloadRequest(KodiDownload *download) const;
+    QNetworkReply *getDownload(KodiDownload *download, const QNetworkRequest &request);
+    void startSegment(KodiDownload *download, const DownloadSegment &segment);
+    bool splitSegment(KodiDownload *download);
+    void tuneSegments(KodiDownload *download);
+    bool writeSegment(QFile *file, DownloadSegment &segment, bool flush);
+    void readDownload(QNetworkReply *reply);
+    void setDownloadRate(qint64 rate);
+    void updateDownloadRate(qint64 commandLatency);
+    void probeLatency();
+    void storeDownload(KodiDownload *download);
+    void forgetDownload(KodiDownload *download);
+    void restoreDownloads();
+    KodiDownload *nextDownload() const;
+    int activeDownloads(const QString &hostId) const;
 
     KodiHost *m_host;
 
     QNetworkAccessManager *m_network;
+    // Downloads get their own connections so they don't hold up commands and artwork
+    QNetworkAccessManager *m_downloadNetwork;
     QNetworkReply *m_lastAuthRequest;
     bool m_connecting;
     bool m_connected;
@@ -161,6 +216,21 @@ private:
 
     QList<KodiDownload*> m_downloadQueue;
     QMap<QNetworkReply*, KodiDownload*> m_activeDownloadsMap;
+    QHash<QNetworkReply*, DownloadSegment> m_segments;
+    QHash<KodiDownload*, QList<DownloadSegment> > m_failedSegments;
+    QHash<KodiDownload*, QList<DownloadSegment> > m_pendingSegments;
+    QHash<KodiDownload*, SegmentTuning> m_segmentTuning;
+    QSet<KodiDownload*> m_brokenDownloads;
+    QSet<KodiDownload*> m_skippedDownloads;
+
+    // Token bucket for download traffic. A rate of 0 means unlimited.
+    qint64 m_downloadRate;
+    qint64 m_downloadTokens;
+    int m_shapingRound;
+    QTimer m_shapingTimer;
+    // Downloads are throttled by the round trip of a periodic JSON-RPC ping
+    QElapsedTimer m_latencyProbeTimer;
+    int m_latencyProbeId;
 
 };
 Q_GLOBAL_STATIC(KodiConnectionPrivate, instance)
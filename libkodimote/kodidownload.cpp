@@ -22,8 +22,19 @@
 
 KodiDownload::KodiDownload(QObject *parent) :
     QObject(parent),
-    m_cancelled(false)
+    m_file(0),
+    m_total(0),
+    m_progress(0),
+    m_cancelled(false),
+    m_batch(0),
+    m_offset(0),
+    m_segmented(false),
+    m_skipExisting(false),
+    m_peakBufferedBytes(0),
+    m_speed(0),
+    m_speedProgress(0)
 {
+    m_speedTimer.invalidate();
 }
 
 void KodiDownload::setSource(const QString &source)
@@ -74,6 +85,13 @@ void KodiDownload::setProgress(qint64 progress)
 {
     m_progress = progress;
     emit progressChanged();
+
+    // Average over at least a second to keep the number steady
+    if(m_speedTimer.isValid() && m_speedTimer.elapsed() >= 1000) {
+        m_speed = (m_progress - m_speedProgress) * 1000 / m_speedTimer.restart();
+        m_speedProgress = m_progress;
+        emit speedChanged();
+    }
 }
 
 qint64 KodiDownload::progress() const
@@ -83,11 +101,16 @@ qint64 KodiDownload::progress() const
 
 void KodiDownload::setStarted()
 {
+    m_speedTimer.start();
+    m_speedProgress = m_progress;
     emit started();
 }
 
 void KodiDownload::setFinished(bool success)
 {
+    m_speedTimer.invalidate();
+    m_speed = 0;
+    emit speedChanged();
     emit finished(success);
 }
 
@@ -116,6 +139,85 @@ bool KodiDownload::isCancelled() const
     return m_cancelled;
 }
 
+void KodiDownload::setBatch(int batch)
+{
+    m_batch = batch;
+}
+
+int KodiDownload::batch() const
+{
+    return m_batch;
+}
+
+int KodiDownload::newBatch()
+{
+    static int lastBatch = 0;
+    return ++lastBatch;
+}
+
+void KodiDownload::setSkipExisting(bool skipExisting)
+{
+    m_skipExisting = skipExisting;
+}
+
+bool KodiDownload::skipExisting() const
+{
+    return m_skipExisting;
+}
+
+qint64 KodiDownload::speed() const
+{
+    return m_speed;
+}
+
+void KodiDownload::setHostId(const QString &hostId)
+{
+    m_hostId = hostId;
+}
+
+QString KodiDownload::hostId() const
+{
+    return m_hostId;
+}
+
+void KodiDownload::setOffset(qint64 offset)
+{
+    m_offset = offset;
+}
+
+qint64 KodiDownload::offset() const
+{
+    return m_offset;
+}
+
+QString KodiDownload::partialFile() const
+{
+    return m_destination + ".part";
+}
+
+void KodiDownload::setBufferedBytes(qint64 bufferedBytes)
+{
+    if(bufferedBytes > m_peakBufferedBytes) {
+        m_peakBufferedBytes = bufferedBytes;
+        emit peakBufferedBytesChanged();
+    }
+}
+
+qint64 KodiDownload::peakBufferedBytes() const
+{
+    return m_peakBufferedBytes;
+}
+
+void KodiDownload::setSegmented(bool segmented)
+{
+    m_segmented = segmented;
+}
+
+bool KodiDownload::segmented() const
+{
+    return m_segmented;
+}
+
 void KodiDownload::cancel()
 {
     emit cancelled();
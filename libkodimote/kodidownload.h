@@ -23,6 +23,7 @@
 
 #include <QObject>
 #include <QFile>
+#include <QElapsedTimer>
 
 class KodiDownload : public QObject
 {
@@ -33,6 +34,8 @@ class KodiDownload : public QObject
     Q_PROPERTY(qint64 progress READ progress WRITE setProgress NOTIFY progressChanged)
     Q_PROPERTY(QString iconId READ iconId WRITE setIconId)
     Q_PROPERTY(QString label READ label WRITE setLabel)
+    Q_PROPERTY(qint64 speed READ speed NOTIFY speedChanged)
+    Q_PROPERTY(qint64 peakBufferedBytes READ peakBufferedBytes NOTIFY peakBufferedBytesChanged)
 
 public:
     explicit KodiDownload(QObject *parent = 0);
@@ -63,11 +66,45 @@ public:
 
     bool isCancelled() const;
 
+    // Downloads sharing a batch (e.g. the songs of an album) are started in order.
+    // Separate batches take turns so a single file doesn't wait behind a whole season.
+    void setBatch(int batch);
+    int batch() const;
+    static int newBatch();
+
+    // Don't download again if the destination already exists with the same size
+    void setSkipExisting(bool skipExisting);
+    bool skipExisting() const;
+
+    // Current transfer rate in bytes per second
+    qint64 speed() const;
+
+    // Id of the host this download belongs to
+    void setHostId(const QString &hostId);
+    QString hostId() const;
+
+    // Bytes already on disk from an earlier attempt
+    void setOffset(qint64 offset);
+    qint64 offset() const;
+
+    // Data is written here and moved to destination() once complete
+    QString partialFile() const;
+
+    // Data received but not written to disk yet. The highest value is kept as peakBufferedBytes.
+    void setBufferedBytes(qint64 bufferedBytes);
+    qint64 peakBufferedBytes() const;
+
+    // Allow fetching large files over several connections at once
+    void setSegmented(bool segmented);
+    bool segmented() const;
+
 signals:
     void sourceChanged();
     void destinationChanged();
     void totalChanged();
     void progressChanged();
+    void speedChanged();
+    void peakBufferedBytesChanged();
     void started();
     void finished(bool success);
 
@@ -85,6 +122,15 @@ private:
     QString m_icon;
     QString m_label;
     bool m_cancelled;
+    int m_batch;
+    QString m_hostId;
+    qint64 m_offset;
+    bool m_segmented;
+    bool m_skipExisting;
+    qint64 m_peakBufferedBytes;
+    qint64 m_speed;
+    QElapsedTimer m_speedTimer;
+    qint64 m_speedProgress;
     
 };
 
@@ -0,0 +1,336 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "kodidownloadjob.h"
+#include "kodidownload.h"
+#include "kodiconnection.h"
+
+#include <QFileInfo>
+#include <QStringList>
+#include <QDebug>
+
+KodiDownloadJob::KodiDownloadJob(const QString &path, const QString &label, QObject *parent) :
+    QObject(parent),
+    m_path(path),
+    m_label(label),
+    m_batch(KodiDownload::newBatch()),
+    m_fileCount(0),
+    m_finishedCount(0),
+    m_failedCount(0),
+    m_finishedBytes(0),
+    m_running(false),
+    m_cancelled(false)
+{
+}
+
+void KodiDownloadJob::downloadAlbum(int albumId)
+{
+    QVariantMap params;
+    QVariantMap filter;
+    filter.insert("albumid", albumId);
+    params.insert("filter", filter);
+    QVariantList properties;
+    properties.append("file");
+    properties.append("title");
+    properties.append("artist");
+    properties.append("album");
+    params.insert("properties", properties);
+
+    start("AudioLibrary.GetSongs", params, "songsReceived");
+}
+
+void KodiDownloadJob::downloadArtist(int artistId)
+{
+    QVariantMap params;
+    QVariantMap filter;
+    filter.insert("artistid", artistId);
+    params.insert("filter", filter);
+    QVariantList properties;
+    properties.append("file");
+    properties.append("title");
+    properties.append("artist");
+    properties.append("album");
+    params.insert("properties", properties);
+
+    start("AudioLibrary.GetSongs", params, "songsReceived");
+}
+
+void KodiDownloadJob::downloadSeason(int tvshowId, int season)
+{
+    QVariantMap params;
+    params.insert("tvshowid", tvshowId);
+    params.insert("season", season);
+    QVariantList properties;
+    properties.append("file");
+    properties.append("title");
+    properties.append("showtitle");
+    properties.append("season");
+    params.insert("properties", properties);
+
+    start("VideoLibrary.GetEpisodes", params, "episodesReceived");
+}
+
+void KodiDownloadJob::downloadDirectory(const QString &directory, const QString &mediaType)
+{
+    QVariantMap params;
+    params.insert("directory", directory);
+    params.insert("media", mediaType);
+    QVariantList properties;
+    properties.append("file");
+    properties.append("size");
+    params.insert("properties", properties);
+
+    // Keep the directory's own name below the usual media folders
+    QString name = QString(directory).replace('\\', '/');
+    while(name.endsWith('/')) {
+        name.chop(1);
+    }
+    name = QFileInfo(name).fileName();
+    if(mediaType == "music") {
+        m_path += "/Music/" + name + '/';
+    } else if(mediaType == "video") {
+        m_path += "/Movies/" + name + '/';
+    } else {
+        m_path += "/Pictures/" + name + '/';
+    }
+
+    m_mediaType = mediaType;
+    start("Files.GetDirectory", params, "directoryReceived");
+}
+
+void KodiDownloadJob::start(const QString &method, const QVariantMap &params, const QString &callback)
+{
+    m_running = true;
+    emit runningChanged();
+    KodiConnection::addDownloadJob(this);
+    if(KodiConnection::sendCommand(method, params, this, callback) < 0) {
+        m_failedCount++;
+        emit progressChanged();
+        checkFinished();
+    }
+}
+
+bool KodiDownloadJob::listFailed(const QVariantMap &rsp)
+{
+    if(!rsp.contains("error")) {
+        return false;
+    }
+    qDebug() << "listing files for download job" << m_label << "failed:" << rsp.value("error");
+    m_failedCount++;
+    emit progressChanged();
+    checkFinished();
+    return true;
+}
+
+void KodiDownloadJob::songsReceived(const QVariantMap &rsp)
+{
+    if(listFailed(rsp)) {
+        return;
+    }
+    foreach(const QVariant &itemVariant, rsp.value("result").toMap().value("songs").toList()) {
+        QVariantMap itemMap = itemVariant.toMap();
+        QString artist = itemMap.value("artist").toString();
+        if(artist.isEmpty() && itemMap.value("artist").toList().count() > 0) {
+            artist = itemMap.value("artist").toStringList().first();
+        }
+        addFile(itemMap.value("file").toString(), m_path + "/Music/" + artist + '/' + itemMap.value("album").toString() + '/',
+                itemMap.value("title").toString(), "icon-m-content-audio", false);
+    }
+    checkFinished();
+}
+
+void KodiDownloadJob::episodesReceived(const QVariantMap &rsp)
+{
+    if(listFailed(rsp)) {
+        return;
+    }
+    foreach(const QVariant &itemVariant, rsp.value("result").toMap().value("episodes").toList()) {
+        QVariantMap itemMap = itemVariant.toMap();
+        addFile(itemMap.value("file").toString(), m_path + "/Movies/" + itemMap.value("showtitle").toString() + "/Season " + QString::number(itemMap.value("season").toInt()) + '/',
+                itemMap.value("title").toString(), "icon-m-content-videos", true);
+    }
+    checkFinished();
+}
+
+void KodiDownloadJob::directoryReceived(const QVariantMap &rsp)
+{
+    if(listFailed(rsp)) {
+        return;
+    }
+
+    QString iconId = "icon-m-content-image";
+    if(m_mediaType == "music") {
+        iconId = "icon-m-content-audio";
+    } else if(m_mediaType == "video") {
+        iconId = "icon-m-content-videos";
+    }
+    foreach(const QVariant &itemVariant, rsp.value("result").toMap().value("files").toList()) {
+        QVariantMap itemMap = itemVariant.toMap();
+        if(itemMap.value("filetype").toString() != "file") {
+            continue;
+        }
+        addFile(itemMap.value("file").toString(), m_path, itemMap.value("label").toString(), iconId,
+                m_mediaType == "video", itemMap.value("size", -1).toLongLong());
+    }
+    checkFinished();
+}
+
+void KodiDownloadJob::addFile(const QString &file, const QString &destination, const QString &label, const QString &iconId, bool segmented, qint64 size)
+{
+    if(m_cancelled || file.isEmpty()) {
+        return;
+    }
+
+    KodiDownload *download = new KodiDownload();
+    QFileInfo fileInfo(QString(file).replace('\\', '/')); // Make sure it works on Windoze too
+    download->setDestination(destination + fileInfo.fileName());
+    download->setLabel(label);
+    download->setIconId(iconId);
+    download->setBatch(m_batch);
+    download->setSkipExisting(true);
+    download->setSegmented(segmented);
+
+    m_fileCount++;
+    emit fileCountChanged();
+
+    // We know the size for directory listings, no need to ask the server
+    QFileInfo existing(download->destination());
+    if(size > 0 && existing.exists() && existing.size() == size) {
+        qDebug() << "skipping download of existing file" << download->destination();
+        m_finishedCount++;
+        m_finishedBytes += size;
+        emit progressChanged();
+        delete download;
+        return;
+    }
+
+    // Prepare all paths at once instead of one by one through the command queue
+    QVariantMap params;
+    params.insert("path", file);
+    int id = KodiConnection::sendParallelCommand("Files.PrepareDownload", params, this, "downloadPrepared");
+    if(id < 0) {
+        m_failedCount++;
+        emit progressChanged();
+        delete download;
+        return;
+    }
+    m_preparing.insert(id, download);
+}
+
+void KodiDownloadJob::downloadPrepared(const QVariantMap &rsp)
+{
+    KodiDownload *download = m_preparing.take(rsp.value("id").toInt());
+    if(!download) {
+        return;
+    }
+    if(m_cancelled || rsp.contains("error")) {
+        if(!m_cancelled) {
+            m_failedCount++;
+            emit progressChanged();
+        }
+        delete download;
+        checkFinished();
+        return;
+    }
+
+    download->setSource(rsp.value("result").toMap().value("details").toMap().value("path").toString());
+    connect(download, SIGNAL(progressChanged()), SIGNAL(progressChanged()));
+    connect(download, SIGNAL(finished(bool)), SLOT(downloadFinished(bool)));
+    m_downloads.append(download);
+    KodiConnection::download(download);
+}
+
+void KodiDownloadJob::downloadFinished(bool success)
+{
+    KodiDownload *download = qobject_cast<KodiDownload*>(sender());
+    m_downloads.removeAll(download);
+    if(success) {
+        m_finishedCount++;
+        m_finishedBytes += download->total();
+    } else {
+        m_failedCount++;
+    }
+    emit progressChanged();
+    checkFinished();
+}
+
+void KodiDownloadJob::checkFinished()
+{
+    if(!m_running || !m_preparing.isEmpty() || !m_downloads.isEmpty()) {
+        return;
+    }
+    qDebug() << "download job" << m_label << "done:" << m_finishedCount << "of" << m_fileCount << "files";
+    m_running = false;
+    emit runningChanged();
+    emit finished(!m_cancelled && m_failedCount == 0);
+    deleteLater();
+}
+
+void KodiDownloadJob::cancel()
+{
+    m_cancelled = true;
+    foreach(KodiDownload *download, m_downloads) {
+        download->cancel();
+    }
+    checkFinished();
+}
+
+QString KodiDownloadJob::label() const
+{
+    return m_label;
+}
+
+int KodiDownloadJob::fileCount() const
+{
+    return m_fileCount;
+}
+
+int KodiDownloadJob::finishedCount() const
+{
+    return m_finishedCount;
+}
+
+int KodiDownloadJob::failedCount() const
+{
+    return m_failedCount;
+}
+
+qint64 KodiDownloadJob::total() const
+{
+    qint64 total = m_finishedBytes;
+    foreach(KodiDownload *download, m_downloads) {
+        total += download->total();
+    }
+    return total;
+}
+
+qint64 KodiDownloadJob::progress() const
+{
+    qint64 progress = m_finishedBytes;
+    foreach(KodiDownload *download, m_downloads) {
+        progress += download->progress();
+    }
+    return progress;
+}
+
+bool KodiDownloadJob::running() const
+{
+    return m_running;
+}
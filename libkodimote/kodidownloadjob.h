@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef KODIDOWNLOADJOB_H
+#define KODIDOWNLOADJOB_H
+
+#include <QObject>
+#include <QVariantMap>
+#include <QMap>
+
+class KodiDownload;
+
+/**
+  * Downloads a whole album, artist, tv show season or directory.
+  * The contents are listed with a single request, the download paths of all
+  * files are prepared at once and queued as one batch. Files that already exist
+  * with the right size are skipped. Started jobs are announced through
+  * Kodi::downloadJobAdded(). The job deletes itself once everything is done.
+  */
+class KodiDownloadJob : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString label READ label CONSTANT)
+    Q_PROPERTY(int fileCount READ fileCount NOTIFY fileCountChanged)
+    Q_PROPERTY(int finishedCount READ finishedCount NOTIFY progressChanged)
+    Q_PROPERTY(int failedCount READ failedCount NOTIFY progressChanged)
+    Q_PROPERTY(qint64 total READ total NOTIFY progressChanged)
+    Q_PROPERTY(qint64 progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+
+public:
+    explicit KodiDownloadJob(const QString &path, const QString &label, QObject *parent = 0);
+
+    void downloadAlbum(int albumId);
+    void downloadArtist(int artistId);
+    void downloadSeason(int tvshowId, int season);
+    void downloadDirectory(const QString &directory, const QString &mediaType);
+
+    QString label() const;
+    int fileCount() const;
+    int finishedCount() const;
+    int failedCount() const;
+    qint64 total() const;
+    qint64 progress() const;
+    bool running() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void fileCountChanged();
+    void progressChanged();
+    void runningChanged();
+    void finished(bool success);
+
+private slots:
+    void songsReceived(const QVariantMap &rsp);
+    void episodesReceived(const QVariantMap &rsp);
+    void directoryReceived(const QVariantMap &rsp);
+    void downloadPrepared(const QVariantMap &rsp);
+    void downloadFinished(bool success);
+
+private:
+    void start(const QString &method, const QVariantMap &params, const QString &callback);
+    bool listFailed(const QVariantMap &rsp);
+    void addFile(const QString &file, const QString &destination, const QString &label, const QString &iconId, bool segmented, qint64 size = -1);
+    void checkFinished();
+
+    QString m_path;
+    QString m_label;
+    QString m_mediaType;
+    int m_batch;
+    int m_fileCount;
+    int m_finishedCount;
+    int m_failedCount;
+    qint64 m_finishedBytes;
+    bool m_running;
+    bool m_cancelled;
+
+    QMap<int, KodiDownload*> m_preparing;
+    QList<KodiDownload*> m_downloads;
+};
+
+#endif // KODIDOWNLOADJOB_H
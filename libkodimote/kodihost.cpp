@@ -12,7 +12,9 @@ KodiHost::KodiHost(const QUuid &id, QObject *parent):
     m_kodiHttpSupported(false),
     m_port(8080),
     m_volumeControlType(VolumeControlTypeAbsolute),
-    m_volumeStepping(5)
+    m_volumeStepping(5),
+    m_imagePathDecoding(ImagePathDecodingUnknown),
+    m_downloadRateLimit(0)
 {
 }
 
@@ -36,6 +38,8 @@ KodiHost *KodiHost::fromSettings(const QUuid &id)
     host->setVolumeDownCommand(settings.value("VolumeDownCommand").toString());
     host->setVolumeControlType((KodiHost::VolumeControlType)settings.value("VolumeControlType", KodiHost::VolumeControlTypeAbsolute).toInt());
     host->setVolumeStepping(settings.value("VolumeStepping", 5).toInt());
+    host->setImagePathDecoding((KodiHost::ImagePathDecoding)settings.value("ImagePathDecoding", KodiHost::ImagePathDecodingUnknown).toInt());
+    host->setDownloadRateLimit(settings.value("DownloadRateLimit", 0).toInt());
     host->setPersistent(true);
     return host;
 }
@@ -224,6 +228,33 @@ void KodiHost::setVolumeStepping(const int stepping)
     }
 }
 
+KodiHost::ImagePathDecoding KodiHost::imagePathDecoding() const
+{
+    return m_imagePathDecoding;
+}
+
+void KodiHost::setImagePathDecoding(ImagePathDecoding decoding)
+{
+    if (m_imagePathDecoding != decoding) {
+        m_imagePathDecoding = decoding;
+        syncToDisk();
+    }
+}
+
+int KodiHost::downloadRateLimit() const
+{
+    return m_downloadRateLimit;
+}
+
+void KodiHost::setDownloadRateLimit(int downloadRateLimit)
+{
+    if (m_downloadRateLimit != downloadRateLimit) {
+        m_downloadRateLimit = downloadRateLimit;
+        emit downloadRateLimitChanged();
+        syncToDisk();
+    }
+}
+
 void KodiHost::connect()
 {
     qDebug() << "connecting host" << parent();
@@ -267,4 +298,6 @@ void KodiHost::syncToDisk()
     settings.setValue("VolumeDownCommand", m_volumeDownCommand);
     settings.setValue("VolumeControlType", m_volumeControlType);
     settings.setValue("VolumeStepping", m_volumeStepping);
+    settings.setValue("ImagePathDecoding", m_imagePathDecoding);
+    settings.setValue("DownloadRateLimit", m_downloadRateLimit);
 }
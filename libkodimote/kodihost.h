@@ -20,6 +20,7 @@ class KodiHost : public QObject
     Q_PROPERTY(QString volumeDownCommand READ volumeDownCommand WRITE setVolumeDownCommand NOTIFY volumeDownCommandChanged)
     Q_PROPERTY(VolumeControlType volumeControlType READ volumeControlType WRITE setVolumeControlType NOTIFY volumeControlTypeChanged)
     Q_PROPERTY(int volumeStepping READ volumeStepping WRITE setVolumeStepping NOTIFY volumeSteppingChanged)
+    Q_PROPERTY(int downloadRateLimit READ downloadRateLimit WRITE setDownloadRateLimit NOTIFY downloadRateLimitChanged)
 
 public:
     enum VolumeControlType {
@@ -28,6 +29,13 @@ public:
         VolumeControlTypeCustom
     };
 
+    // Some Kodi versions expect image paths to be percent decoded once, some twice
+    enum ImagePathDecoding {
+        ImagePathDecodingUnknown,
+        ImagePathDecodingSingle,
+        ImagePathDecodingDouble
+    };
+
     explicit KodiHost(const QUuid &id = QUuid::createUuid(), QObject *parent = 0);
     static KodiHost* fromSettings(const QUuid &id);
 
@@ -71,6 +79,13 @@ public:
     int volumeStepping() const;
     void setVolumeStepping(const int stepping);
 
+    ImagePathDecoding imagePathDecoding() const;
+    void setImagePathDecoding(ImagePathDecoding decoding);
+
+    // Upper limit for downloads from this host in KiB/s, 0 for no limit
+    int downloadRateLimit() const;
+    void setDownloadRateLimit(int downloadRateLimit);
+
 public slots:
     void connect();
     void wakeup();
@@ -88,6 +103,7 @@ signals:
     void volumeDownCommandChanged();
     void volumeControlTypeChanged();
     void volumeSteppingChanged();
+    void downloadRateLimitChanged();
 
 private:
     void syncToDisk();
@@ -107,6 +123,8 @@ private:
     QString m_volumeDownCommand;
     VolumeControlType m_volumeControlType;
     int m_volumeStepping;
+    ImagePathDecoding m_imagePathDecoding;
+    int m_downloadRateLimit;
 };
 
 #endif // XBMCHOST_H
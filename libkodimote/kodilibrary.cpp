@@ -27,13 +27,14 @@
 #include "player.h"
 #include "audioplayer.h"
 #include "videoplayer.h"
+#include "modelcache.h"
 
 #include "libraryitem.h"
 
 #include <QTimer>
 #include <QFileInfo>
 
-KodiLibrary::KodiLibrary(KodiModel *parent) :KodiModel(parent), m_deleteAfterDownload(false)
+KodiLibrary::KodiLibrary(KodiModel *parent) :KodiModel(parent), m_deleteAfterDownload(false), m_downloadBatch(0)
 {
     // Refresh the model automatically on the next event loop run.
     // This is to give QML time to create the object and set properties before the refresh
@@ -86,8 +87,24 @@ QVariant KodiLibrary::data(const QModelIndex &index, int role) const
 
 KodiModel* KodiLibrary::exit()
 {
-    deleteLater();
-    return m_parentModel;
+    KodiModel *parentModel = m_parentModel;
+    // Don't keep models that haven't finished loading
+    if (m_cacheKey.isEmpty() || busy()) {
+        deleteLater();
+    } else {
+        Kodi::instance()->modelCache()->insert(m_cacheKey, this);
+    }
+    return parentModel;
+}
+
+void KodiLibrary::setCacheKey(const QString &cacheKey)
+{
+    m_cacheKey = cacheKey;
+}
+
+KodiModel *KodiLibrary::cachedModel(const QString &cacheKey)
+{
+    return Kodi::instance()->modelCache()->take(cacheKey, this);
 }
 
 QVariant KodiLibrary::get(int row, const QString &roleName)
@@ -124,6 +141,12 @@ void KodiLibrary::startDownload(int index, KodiDownload *download)
     QFileInfo fileInfo(item->fileName().replace('\\', '/')); // Make sure it works on Windoze too
     download->setDestination(download->destination() + fileInfo.fileName());
 
+    // Everything downloaded through one model is a batch
+    if(m_downloadBatch == 0) {
+        m_downloadBatch = KodiDownload::newBatch();
+    }
+    download->setBatch(m_downloadBatch);
+
     QVariantMap params;
     params.insert("path", item->fileName());
     int id = KodiConnection::sendCommand("Files.PrepareDownload", params, this, "downloadReceived");
@@ -45,6 +45,8 @@ public:
     Q_INVOKABLE KodiModelItem *getItem(int index);
 
     Q_INVOKABLE virtual void fetchItemDetails(int index) { Q_UNUSED(index) }
+    /** Fetch details for rows first..last (e.g. the visible ones) in one request so fetchItemDetails() can be served from the cache */
+    Q_INVOKABLE virtual void prefetchItemDetails(int first, int last) { Q_UNUSED(first) Q_UNUSED(last) }
     Q_INVOKABLE virtual bool hasShortDetails() { return false; }
     Q_INVOKABLE virtual bool hasDetails() { return false; }
 
@@ -55,6 +57,10 @@ public:
 protected:
     void startDownload(int index, KodiDownload *download);
 
+    /** Models with a cache key are kept in the model cache on exit() instead of being deleted */
+    void setCacheKey(const QString &cacheKey);
+    KodiModel *cachedModel(const QString &cacheKey);
+
 private slots:
     void downloadReceived(const QVariantMap &rsp);
 
@@ -63,6 +69,8 @@ private slots:
 private:
     QMap<int, KodiDownload*> m_downloadMap;
     bool m_deleteAfterDownload;
+    int m_downloadBatch;
+    QString m_cacheKey;
 
 };
 
@@ -22,37 +22,62 @@
 #include "kodi.h"
 #include "imagecache.h"
 #include "player.h"
+#ifdef QT5_BUILD
+#include "imageprovider.h"
+#endif
 
+#include <QSet>
 #include <QDebug>
 
+static QString sectionForKey(const QString &key)
+{
+    if(key.isEmpty() || !key.at(0).isLetter()) {
+        return "#";
+    }
+    return key.left(1).toUpper();
+}
+
 KodiModel::KodiModel(KodiModel *parent) :
     QAbstractItemModel(parent),
     m_parentModel(parent),
     m_busy(true),
-    m_ignoreArticle(false)
+    m_ignoreArticle(false),
+    m_sectionsValid(false),
+    m_sectionsChangePending(false)
 {
-#ifndef QT5_BUILD
-    setRoleNames(roleNames());
-#endif
+    init();
 }
 
 KodiModel::KodiModel(QObject *parent) :
     QAbstractItemModel(parent),
     m_parentModel(0),
     m_busy(true),
-    m_ignoreArticle(false)
+    m_ignoreArticle(false),
+    m_sectionsValid(false),
+    m_sectionsChangePending(false)
+{
+    init();
+}
+
+void KodiModel::init()
 {
 #ifndef QT5_BUILD
     setRoleNames(roleNames());
 #endif
+
+    connect(this, SIGNAL(rowsInserted(QModelIndex,int,int)), SLOT(invalidateSections()));
+    connect(this, SIGNAL(rowsRemoved(QModelIndex,int,int)), SLOT(invalidateSections()));
+    connect(this, SIGNAL(modelReset()), SLOT(invalidateSections()));
+    connect(this, SIGNAL(ignoreArticleChanged()), SLOT(invalidateSections()));
 }
 
 KodiModel::~KodiModel()
 {
-    qDebug() << "deleting model";
-    while(!m_list.isEmpty()) {
-        m_list.takeFirst()->deleteLater();
-    }
+    // Delete the items right away and in list order. They are our children, so
+    // removing them front to back keeps QObject's bookkeeping linear instead of
+    // posting a deferred delete event per row.
+    qDeleteAll(m_list);
+    m_list.clear();
 }
 
 KodiModel *KodiModel::parentModel() const
@@ -60,6 +85,11 @@ KodiModel *KodiModel::parentModel() const
     return m_parentModel;
 }
 
+void KodiModel::setParentModel(KodiModel *parentModel)
+{
+    m_parentModel = parentModel;
+}
+
 QVariant KodiModel::data(const QModelIndex &index, int role) const
 {
     if(index.row() < 0 || index.row() >= m_list.count()) {
@@ -73,12 +103,21 @@ QVariant KodiModel::data(const QModelIndex &index, int role) const
         }
         QString cachedFile;
         if(Kodi::instance()->imageCache()->contains(thumbnail, 0, cachedFile)) {
+#ifdef QT5_BUILD
+            return KodiImageProvider::url(thumbnail, 0);
+#else
             return cachedFile;
+#endif
         }
         // Size optimized for list view icons.
-        int job = Kodi::instance()->imageCache()->fetch(thumbnail, const_cast<KodiModel*>(this), "imageFetched", QSize(152, 120), 0);
+        int job = Kodi::instance()->imageCache()->fetch(thumbnail, const_cast<KodiModel*>(this), "imageFetched", KodiImageCache::cacheSize(0), 0);
         m_imageFetchJobs.insert(job, index.row());
-        return QString("loading");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+        // Already queued, the image provider will pick it up from there
+        return KodiImageProvider::url(thumbnail, 0);
+#else
+        return QString();
+#endif
     }
     if(role == RoleLargeThumbnail) {
         QString thumbnail = m_list.at(index.row())->data(RoleThumbnail).toString();
@@ -87,12 +126,26 @@ QVariant KodiModel::data(const QModelIndex &index, int role) const
         }
         QString cachedFile;
         if(Kodi::instance()->imageCache()->contains(thumbnail, 1, cachedFile)) {
+#ifdef QT5_BUILD
+            return KodiImageProvider::url(thumbnail, 1);
+#else
             return cachedFile;
+#endif
         }
         // Size optimized for big representations.
-        int job = Kodi::instance()->imageCache()->fetch(thumbnail, const_cast<KodiModel*>(this), "imageFetched", QSize(1000, 1000), 1);
+        int job = Kodi::instance()->imageCache()->fetch(thumbnail, const_cast<KodiModel*>(this), "imageFetched", KodiImageCache::cacheSize(1), 1);
         m_imageFetchJobs.insert(job, index.row());
-        return QString("loading");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+        // Already queued, the image provider will pick it up from there
+        return KodiImageProvider::url(thumbnail, 1);
+#else
+        return QString();
+#endif
+    }
+    if(role == RolePreviewColor) {
+        QString thumbnail = m_list.at(index.row())->data(RoleThumbnail).toString();
+        QColor color = thumbnail.isEmpty() ? QColor() : Kodi::instance()->imageCache()->previewColor(thumbnail);
+        return color.isValid() ? color : QColor(Qt::transparent);
     }
     if(role == RoleDuration) {
         QTime duration = m_list.at(index.row())->data(role).toTime();
@@ -124,20 +177,114 @@ QModelIndex KodiModel::parent(const QModelIndex &child) const
 
 int KodiModel::findItem(const QString &string, bool caseSensitive)
 {
-    foreach(KodiModelItem* item, m_list) {
-        if(caseSensitive) {
-            if(item->data(RoleTitle).toString().startsWith(string)) {
-                return m_list.indexOf(item);
-            }
-        } else {
-            if(item->data(RoleTitle).toString().toLower().startsWith(string.toLower())) {
-                return m_list.indexOf(item);
-            }
+    // Jumping to a letter doesn't need to look at the items at all
+    if(string.length() == 1 && string.at(0).isLetter() && !caseSensitive) {
+        return sectionRow(string);
+    }
+
+    if(!m_sectionsValid) {
+        buildSections();
+    }
+    Qt::CaseSensitivity cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    for(int i = 0; i < m_sortKeys.count(); ++i) {
+        QString key = m_sortKeys.at(i);
+        // The row may have been loaded since the index was built
+        if(key.isNull() && !sortKey(i, key)) {
+            continue;
+        }
+        if(key.startsWith(string, cs)) {
+            return i;
+        }
+        // Typing the article still finds the item
+        QString title;
+        if(m_ignoreArticle && itemTitle(i, title) && title.startsWith(string, cs)) {
+            return i;
         }
     }
     return -1;
 }
 
+bool KodiModel::itemTitle(int row, QString &title) const
+{
+    title = m_list.at(row)->data(RoleTitle).toString();
+    return true;
+}
+
+QStringList KodiModel::sections() const
+{
+    if(!m_sectionsValid) {
+        buildSections();
+    }
+    return m_sections;
+}
+
+int KodiModel::sectionRow(const QString &section) const
+{
+    if(!m_sectionsValid) {
+        buildSections();
+    }
+    return m_sectionRows.value(section.toUpper(), -1);
+}
+
+QString KodiModel::sectionForRow(int row) const
+{
+    if(row < 0 || row >= rowCount()) {
+        return QString();
+    }
+
+    QString key;
+    if(!sortKey(row, key)) {
+        return QString();
+    }
+    return sectionForKey(key);
+}
+
+bool KodiModel::sortKey(int row, QString &key) const
+{
+    if(!itemTitle(row, key)) {
+        return false;
+    }
+    if(m_ignoreArticle && key.startsWith("The ", Qt::CaseInsensitive)) {
+        key = key.mid(4);
+    }
+    return true;
+}
+
+void KodiModel::buildSections() const
+{
+    m_sections.clear();
+    m_sectionRows.clear();
+    m_sortKeys.clear();
+    int count = rowCount();
+    for(int i = 0; i < count; ++i) {
+        QString key;
+        if(!sortKey(i, key)) {
+            m_sortKeys.append(QString());
+            continue;
+        }
+        // Never null for loaded rows, even with an empty title
+        m_sortKeys.append(key.isNull() ? QString("") : key);
+        QString section = sectionForKey(key);
+        // Keep the first occurrence if the sorting isn't strictly alphabetical
+        if(!m_sectionRows.contains(section)) {
+            m_sectionRows.insert(section, i);
+            m_sections.append(section);
+        }
+    }
+    m_sectionsValid = true;
+}
+
+void KodiModel::invalidateSections()
+{
+    m_sectionsValid = false;
+    // Lists arrive in pages, tell the views only once they are complete
+    if(m_busy) {
+        m_sectionsChangePending = true;
+        return;
+    }
+    emit sectionsChanged();
+}
+
 QHash<int, QByteArray> KodiModel::roleNames() const
 {
     QHash<int, QByteArray> roleNames;
@@ -174,6 +321,7 @@ QHash<int, QByteArray> KodiModel::roleNames() const
     roleNames.insert(RoleCast, "cast");
     roleNames.insert(RolePlayingState, "playingState");
     roleNames.insert(RoleLockMode, "lockMode");
+    roleNames.insert(RolePreviewColor, "previewColor");
     return roleNames;
 }
 
@@ -186,6 +334,10 @@ void KodiModel::setBusy(bool busy)
 {
     m_busy = busy;
     emit busyChanged();
+    if(!busy && m_sectionsChangePending) {
+        m_sectionsChangePending = false;
+        emit sectionsChanged();
+    }
 }
 
 bool KodiModel::ignoreArticle() const
@@ -203,7 +355,31 @@ void KodiModel::imageFetched(int id)
 {
     if(m_imageFetchJobs.contains(id)) {
         QModelIndex changedIndex = index(m_imageFetchJobs.value(id), 0, QModelIndex());
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+        // The url didn't change, only the placeholder colour is new
+        emit dataChanged(changedIndex, changedIndex, QVector<int>() << RolePreviewColor);
+#else
         emit dataChanged(changedIndex, changedIndex);
+#endif
         m_imageFetchJobs.remove(id);
     }
 }
+
+void KodiModel::setVisibleRows(const QVariantList &rows)
+{
+    // A filter scatters the visible rows over the model, a range could span all of it
+    QSet<int> visibleRows;
+    foreach(const QVariant &row, rows) {
+        visibleRows.insert(row.toInt());
+    }
+
+    QHash<int, int>::iterator it = m_imageFetchJobs.begin();
+    while(it != m_imageFetchJobs.end()) {
+        if(!visibleRows.contains(it.value())) {
+            Kodi::instance()->imageCache()->cancel(it.key(), this);
+            it = m_imageFetchJobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -24,6 +24,7 @@
 #include "kodimodelitem.h"
 
 #include <QAbstractItemModel>
+#include <QStringList>
 #include <QDebug>
 
 class KodiModel : public QAbstractItemModel
@@ -38,6 +39,7 @@ class KodiModel : public QAbstractItemModel
     Q_PROPERTY(ThumbnailFormat thumbnailFormat READ thumbnailFormat NOTIFY thumbnailFormatChanged)
     Q_PROPERTY(bool allowSearch READ allowSearch NOTIFY allowSearchChanged)
     Q_PROPERTY(bool allowWatchedFilter READ allowWatchedFilter NOTIFY allowWatchedFilterChanged)
+    Q_PROPERTY(QStringList sections READ sections NOTIFY sectionsChanged)
 
 public:
     enum Roles {
@@ -84,7 +86,8 @@ public:
         RolePlaycount,
         RoleCast,
         RolePlayingState,
-        RoleLockMode
+        RoleLockMode,
+        RolePreviewColor
     };
 
     enum ThumbnailFormat {
@@ -112,6 +115,7 @@ public:
     explicit KodiModel(QObject *parent = 0);
     virtual ~KodiModel();
     Q_INVOKABLE KodiModel *parentModel() const;
+    void setParentModel(KodiModel *parentModel);
 
     virtual QVariant data(const QModelIndex &index, int role) const;
 
@@ -123,6 +127,12 @@ public:
 
     Q_INVOKABLE int findItem(const QString &string, bool caseSensitive = false);
 
+    /** The first letters ("#" for anything else) of the items in the order they appear in the model */
+    QStringList sections() const;
+    /** Returns the first row of the given section or -1 if there is no such section */
+    Q_INVOKABLE int sectionRow(const QString &section) const;
+    Q_INVOKABLE QString sectionForRow(int row) const;
+
     Q_INVOKABLE virtual int rowCount(const QModelIndex &parent = QModelIndex()) const
     {
         Q_UNUSED(parent)
@@ -142,9 +152,15 @@ public:
     virtual bool allowWatchedFilter() { return false; }
 
     Q_INVOKABLE void imageFetched(int id);
+
+    // Drops queued artwork fetches for rows that scrolled out of view. "rows" lists the ones still visible.
+    Q_INVOKABLE void setVisibleRows(const QVariantList &rows);
 public slots:
     virtual void refresh() = 0;
 
+private slots:
+    void invalidateSections();
+
 signals:
     void titleChanged();
     void layoutChanged();
@@ -153,15 +169,32 @@ signals:
     void thumbnailFormatChanged();
     void allowSearchChanged();
     void allowWatchedFilterChanged();
+    void sectionsChanged();
 
 protected:
+    /// Title of row for searching and sections. Returns false for rows that aren't loaded, those are skipped.
+    virtual bool itemTitle(int row, QString &title) const;
+
     KodiModel *m_parentModel;
     QList<KodiModelItem*> m_list;
 
 private:
+    void init();
+    void buildSections() const;
+    bool sortKey(int row, QString &key) const;
+
     bool m_busy;
     bool m_ignoreArticle;
 
+    // Built on demand after the rows changed
+    mutable bool m_sectionsValid;
+    mutable QStringList m_sections;
+    mutable QHash<QString, int> m_sectionRows;
+    // Titles as sorted by the server, without the article if it is ignored. Null for rows that aren't loaded.
+    mutable QStringList m_sortKeys;
+    // Rows changed while busy. sectionsChanged is emitted once loading finished.
+    bool m_sectionsChangePending;
+
     mutable QHash<int, int> m_imageFetchJobs; // This is a cache... needs to be modified in data() which is const
 };
 
@@ -37,7 +37,6 @@ KodiModelItem::KodiModelItem(QObject *parent):
 
 KodiModelItem::~KodiModelItem()
 {
-    qDebug() << "deleting model item" << m_title;
 }
 
 QVariant KodiModelItem::data(int role) const
@@ -58,8 +58,14 @@ SOURCES +=  kodi.cpp \
             episodeitem.cpp \
             kodihostmodel.cpp \
             kodidownload.cpp \
+            kodidownloadjob.cpp \
             kodifiltermodel.cpp \
             imagecache.cpp \
+            thumbnailpack.cpp \
+            artworkwarmup.cpp \
+            detailscache.cpp \
+            entitystore.cpp \
+            modelcache.cpp \
             kodidiscovery.cpp \
             networkauthhandler.cpp \
             networkaccessmanagerfactory.cpp \
@@ -115,8 +121,14 @@ HEADERS += libkodimote_global.h \
            episodeitem.h \
            kodihostmodel.h \
            kodidownload.h \
+           kodidownloadjob.h \
            kodifiltermodel.h \
            imagecache.h \
+           thumbnailpack.h \
+           artworkwarmup.h \
+           detailscache.h \
+           entitystore.h \
+           modelcache.h \
            kodidiscovery.h \
            networkauthhandler.h \
            networkaccessmanagerfactory.h \
@@ -133,3 +145,8 @@ HEADERS += libkodimote_global.h \
            addonsource.h \
            profiles.h \
            profileitem.h
+
+contains(DEFINES, QT5_BUILD) {
+    SOURCES += imageprovider.cpp
+    HEADERS += imageprovider.h
+}
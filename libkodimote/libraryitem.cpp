@@ -22,6 +22,10 @@
 
 #include "kodi.h"
 #include "imagecache.h"
+#include "entitystore.h"
+#ifdef QT5_BUILD
+#include "imageprovider.h"
+#endif
 
 LibraryItem::LibraryItem(const QString &title, const QString &subTitle, QObject *parent):
     KodiModelItem(title, subTitle, parent)
@@ -186,19 +190,26 @@ void LibraryItem::setFileName(const QString &fileName)
 
 QString LibraryItem::thumbnail() const
 {
-    qDebug() << "thumbnail" << m_thumbnail;
     if (m_thumbnail.isEmpty()) {
         return QString();
     }
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+    return KodiImageProvider::url(m_thumbnail, 1);
+#else
     QString cachedFile;
     if(Kodi::instance()->imageCache()->contains(m_thumbnail, 1, cachedFile)) {
+#ifdef QT5_BUILD
+        return KodiImageProvider::url(m_thumbnail, 1);
+#else
         return cachedFile;
+#endif
     }
     // scaleTo size optimized for big representations.
-    int id = Kodi::instance()->imageCache()->fetch(m_thumbnail, const_cast<LibraryItem*>(this), "imageFetched", QSize(1000, 1000), 1);
+    int id = Kodi::instance()->imageCache()->fetch(m_thumbnail, const_cast<LibraryItem*>(this), "imageFetched", KodiImageCache::cacheSize(1), 1);
     m_imageFetchJobs.insert(id, ImageTypeThumbnail);
-    return QString("loading");
+    return QString();
+#endif
 }
 
 void LibraryItem::setThumbnail(const QString &thumbnail)
@@ -209,13 +220,24 @@ void LibraryItem::setThumbnail(const QString &thumbnail)
 
 QString LibraryItem::fanart() const
 {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+    if (m_fanart.isEmpty()) {
+        return QString();
+    }
+    return KodiImageProvider::url(m_fanart, 1);
+#else
     QString cachedFile;
     if(Kodi::instance()->imageCache()->contains(m_fanart, 1, cachedFile)) {
+#ifdef QT5_BUILD
+        return KodiImageProvider::url(m_fanart, 1);
+#else
         return cachedFile;
+#endif
     }
-    int id = Kodi::instance()->imageCache()->fetch(m_fanart, const_cast<LibraryItem*>(this), "imageFetched", QSize(1000, 1000), 1);
+    int id = Kodi::instance()->imageCache()->fetch(m_fanart, const_cast<LibraryItem*>(this), "imageFetched", KodiImageCache::cacheSize(1), 1);
     m_imageFetchJobs.insert(id, ImageTypeFanart);
     return QString();
+#endif
 }
 
 void LibraryItem::setFanart(const QString &fanart)
@@ -264,7 +286,7 @@ QString LibraryItem::artist() const
 
 void LibraryItem::setArtist(const QString &artist)
 {
-    m_artist = artist;
+    m_artist = Kodi::instance()->entityStore()->intern(artist);
     emit artistChanged();
 }
 
@@ -286,7 +308,7 @@ QString LibraryItem::album() const
 
 void LibraryItem::setAlbum(const QString &album)
 {
-    m_album = album;
+    m_album = Kodi::instance()->entityStore()->intern(album);
     emit albumChanged();
 }
 
@@ -298,6 +320,9 @@ int LibraryItem::songId() const
 void LibraryItem::setSongId(int songId)
 {
     m_songId = songId;
+    if (songId >= 0) {
+        Kodi::instance()->entityStore()->registerItem("song", songId, this);
+    }
     emit songIdChanged();
 }
 
@@ -320,6 +345,9 @@ int LibraryItem::musicvideoId() const
 void LibraryItem::setMusicvideoId(int musicvideoId)
 {
     m_musicvideoId = musicvideoId;
+    if (musicvideoId >= 0) {
+        Kodi::instance()->entityStore()->registerItem("musicvideo", musicvideoId, this);
+    }
     emit musicvideoIdChanged();
 }
 
@@ -341,7 +369,7 @@ QString LibraryItem::tvShow() const
 
 void LibraryItem::setTvShow(QString tvShow)
 {
-    m_tvShow = tvShow;
+    m_tvShow = Kodi::instance()->entityStore()->intern(tvShow);
     emit tvShowChanged();
 }
 
@@ -364,6 +392,9 @@ int LibraryItem::episodeId() const
 void LibraryItem::setEpisodeId(int episodeId)
 {
     m_episodeId = episodeId;
+    if (episodeId >= 0) {
+        Kodi::instance()->entityStore()->registerItem("episode", episodeId, this);
+    }
     emit episodeIdChanged();
 }
 
@@ -375,6 +406,9 @@ int LibraryItem::movieId() const
 void LibraryItem::setMovieId(int movieId)
 {
     m_movieId = movieId;
+    if (movieId >= 0) {
+        Kodi::instance()->entityStore()->registerItem("movie", movieId, this);
+    }
     emit movieIdChanged();
 }
 
@@ -474,7 +508,7 @@ QString LibraryItem::genre() const
 
 void LibraryItem::setGenre(const QString &genre)
 {
-    m_genre = genre;
+    m_genre = Kodi::instance()->entityStore()->intern(genre);
     emit genreChanged();
 }
 
@@ -485,7 +519,7 @@ QString LibraryItem::year() const
 
 void LibraryItem::setYear(const QString &year)
 {
-    m_year = year;
+    m_year = Kodi::instance()->entityStore()->intern(year);
     emit yearChanged();
 }
 
@@ -496,7 +530,7 @@ QString LibraryItem::director() const
 
 void LibraryItem::setDirector(const QString &director)
 {
-    m_director = director;
+    m_director = Kodi::instance()->entityStore()->intern(director);
     emit directorChanged();
 }
 
@@ -518,7 +552,7 @@ QString LibraryItem::mpaa() const
 
 void LibraryItem::setMpaa(const QString &mpaa)
 {
-    m_mpaa = mpaa;
+    m_mpaa = Kodi::instance()->entityStore()->intern(mpaa);
     emit mpaaChanged();
 }
 
@@ -551,7 +585,7 @@ QString LibraryItem::style() const
 
 void LibraryItem::setStyle(const QString &style)
 {
-    m_style = style;
+    m_style = Kodi::instance()->entityStore()->intern(style);
     emit styleChanged();
 }
 
@@ -562,7 +596,7 @@ QString LibraryItem::mood() const
 
 void LibraryItem::setMood(const QString &mood)
 {
-    m_mood = mood;
+    m_mood = Kodi::instance()->entityStore()->intern(mood);
     emit moodChanged();
 }
 
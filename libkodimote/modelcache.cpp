@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "modelcache.h"
+#include "kodimodel.h"
+#include "kodiconnection.h"
+#include "settings.h"
+
+#include <QDebug>
+
+KodiModelCache::KodiModelCache(QObject *parent) :
+    QObject(parent),
+    m_rowBudget(20000),
+    m_maxAge(600),
+    m_host(0)
+{
+    connect(KodiConnection::notifier(), SIGNAL(connectionChanged()), SLOT(connectionChanged()));
+    connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
+}
+
+void KodiModelCache::insert(const QString &key, KodiModel *model)
+{
+    QString cacheKey = sortedKey(key, model->ignoreArticle());
+
+    // There might be an older instance around if the same model has been opened twice
+    for (int i = 0; i < m_entries.count(); ++i) {
+        if (m_entries.at(i).key() == cacheKey) {
+            KodiModel *oldModel = m_entries.takeAt(i).model();
+            disconnect(oldModel, SIGNAL(destroyed(QObject*)), this, SLOT(modelDestroyed(QObject*)));
+            oldModel->deleteLater();
+            break;
+        }
+    }
+
+    // Take ownership so the model survives its parent going away
+    model->setParent(this);
+    model->setParentModel(0);
+    connect(model, SIGNAL(destroyed(QObject*)), SLOT(modelDestroyed(QObject*)));
+    m_entries.append(Entry(cacheKey, model));
+
+    evict();
+}
+
+KodiModel *KodiModelCache::take(const QString &key, KodiModel *parent)
+{
+    // The UI applies the ignoreArticle setting to every model it enters
+    QString cacheKey = sortedKey(key, Settings().ignoreArticle());
+    for (int i = 0; i < m_entries.count(); ++i) {
+        if (m_entries.at(i).key() != cacheKey) {
+            continue;
+        }
+
+        Entry entry = m_entries.takeAt(i);
+        KodiModel *model = entry.model();
+        disconnect(model, SIGNAL(destroyed(QObject*)), this, SLOT(modelDestroyed(QObject*)));
+
+        if (entry.age() > m_maxAge) {
+            qDebug() << "cached model" << cacheKey << "is stale. Rebuilding it";
+            model->deleteLater();
+            return 0;
+        }
+
+        model->setParent(parent);
+        model->setParentModel(parent);
+        return model;
+    }
+    return 0;
+}
+
+int KodiModelCache::rowBudget() const
+{
+    return m_rowBudget;
+}
+
+void KodiModelCache::setRowBudget(int rowBudget)
+{
+    m_rowBudget = rowBudget;
+    evict();
+}
+
+int KodiModelCache::maxAge() const
+{
+    return m_maxAge;
+}
+
+void KodiModelCache::setMaxAge(int seconds)
+{
+    m_maxAge = seconds;
+}
+
+void KodiModelCache::clear()
+{
+    while (!m_entries.isEmpty()) {
+        KodiModel *model = m_entries.takeFirst().model();
+        disconnect(model, SIGNAL(destroyed(QObject*)), this, SLOT(modelDestroyed(QObject*)));
+        model->deleteLater();
+    }
+}
+
+void KodiModelCache::evict()
+{
+    int rows = 0;
+    foreach (const Entry &entry, m_entries) {
+        rows += entry.model()->rowCount();
+    }
+
+    while (rows > m_rowBudget && !m_entries.isEmpty()) {
+        KodiModel *model = m_entries.takeFirst().model();
+        rows -= model->rowCount();
+        disconnect(model, SIGNAL(destroyed(QObject*)), this, SLOT(modelDestroyed(QObject*)));
+        model->deleteLater();
+    }
+}
+
+void KodiModelCache::modelDestroyed(QObject *model)
+{
+    for (int i = 0; i < m_entries.count(); ++i) {
+        if (m_entries.at(i).model() == model) {
+            m_entries.removeAt(i);
+            return;
+        }
+    }
+}
+
+void KodiModelCache::connectionChanged()
+{
+    if (KodiConnection::connectedHost() != m_host) {
+        m_host = KodiConnection::connectedHost();
+        clear();
+    }
+}
+
+void KodiModelCache::receivedAnnouncement(const QVariantMap &map)
+{
+    // Library contents changed. Don't try to figure out which models are affected
+    QString method = map.value("method").toString();
+    if (method == "AudioLibrary.OnScanFinished" || method == "AudioLibrary.OnCleanFinished" || method == "AudioLibrary.OnRemove" ||
+            method == "VideoLibrary.OnScanFinished" || method == "VideoLibrary.OnCleanFinished" || method == "VideoLibrary.OnRemove") {
+        clear();
+    }
+}
+
+QString KodiModelCache::sortedKey(const QString &key, bool ignoreArticle)
+{
+    return key + (ignoreArticle ? "/ignorearticle" : "");
+}
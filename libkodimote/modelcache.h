@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include <QObject>
+#include <QList>
+#include <QElapsedTimer>
+#include <QVariantMap>
+
+class KodiModel;
+class KodiHost;
+
+/**
+  * Keeps models the user navigated away from, so going back to them or entering
+  * them again doesn't require to fetch and build them from scratch.
+  * Models are identified by a key describing their contents (type and filter ids),
+  * the sorting (ignoreArticle setting) is added by the cache. The least recently used ones
+  * are dropped when the total number of rows exceeds the budget. Entries older than
+  * maxAge are considered stale and get rebuilt when entered again.
+  */
+class KodiModelCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KodiModelCache(QObject *parent = 0);
+
+    /** Hands over the model to the cache. */
+    void insert(const QString &key, KodiModel *model);
+
+    /** Returns the cached model for key, reparented to parent, or 0 if there is no up to date one. */
+    KodiModel *take(const QString &key, KodiModel *parent);
+
+    int rowBudget() const;
+    void setRowBudget(int rowBudget);
+
+    int maxAge() const;
+    void setMaxAge(int seconds);
+
+public slots:
+    void clear();
+
+private slots:
+    void modelDestroyed(QObject *model);
+    void connectionChanged();
+    void receivedAnnouncement(const QVariantMap &map);
+
+private:
+    class Entry
+    {
+    public:
+        Entry(const QString &key = QString(), KodiModel *model = 0):
+            m_key(key), m_model(model) { m_inserted.start(); }
+
+        QString key() const { return m_key; }
+        KodiModel *model() const { return m_model; }
+        int age() const { return m_inserted.elapsed() / 1000; }
+
+    private:
+        QString m_key;
+        KodiModel *m_model;
+        QElapsedTimer m_inserted;
+    };
+
+    static QString sortedKey(const QString &key, bool ignoreArticle);
+    void evict();
+
+    // least recently used first
+    QList<Entry> m_entries;
+    int m_rowBudget;
+    int m_maxAge;
+    KodiHost *m_host;
+};
+
+#endif // MODELCACHE_H
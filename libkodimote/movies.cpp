@@ -25,50 +25,33 @@
 #include "videoplaylist.h"
 #include "videoplaylistitem.h"
 #include "libraryitem.h"
+#include "entitystore.h"
 #include "kodidownload.h"
+#include "detailscache.h"
 
 Movies::Movies(bool recentlyAdded, KodiModel *parent) :
     KodiLibrary(parent),
     m_recentlyAdded(recentlyAdded)
 {
-    connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
+    if (!recentlyAdded) {
+        setCacheKey(cacheKey());
+    }
+    connect(Kodi::instance()->entityStore(), SIGNAL(itemUpdated(QString,int)), SLOT(itemUpdated(QString,int)));
 }
 
 Movies::~Movies()
 {
 }
 
-void Movies::receivedAnnouncement(const QVariantMap &map)
+void Movies::itemUpdated(const QString &type, int id)
 {
-    QString method = map.value("method").toString();
-
-    if(method != "VideoLibrary.OnUpdate") {
-        return;
-    }
-
-    QVariantMap data = map.value("params").toMap().value("data").toMap();
-
-    QVariant playcount = data.value("playcount");
-    if(!playcount.isValid() || playcount.toInt() < 0) {
-        return;
-    }
-
-    QString type = data.value("item").toMap().value("type").toString();
-    int id = data.value("item").toMap().value("id").toInt();
+    // The item itself has already been updated by the entity store
     if(type != "movie" || !m_idIndexMapping.contains(id)) {
         return;
     }
 
     int i = m_idIndexMapping.value(id);
-    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(i));
-
-    if(playcount.toInt() == item->playcount()) {
-        return;
-    }
-
-
-    item->setPlaycount(playcount.toInt());
-    dataChanged(index(i, 0, QModelIndex()), index(i, 0, QModelIndex()));
+    emit dataChanged(index(i, 0, QModelIndex()), index(i, 0, QModelIndex()));
 }
 
 void Movies::refresh()
@@ -83,25 +66,26 @@ void Movies::refresh()
     properties.append("year");
     params.insert("properties", properties);
 
+    sendListCommand(params, "listReceived");
+}
 
+int Movies::sendListCommand(QVariantMap params, const QString &callback)
+{
     if (m_recentlyAdded) {
-        KodiConnection::sendCommand("VideoLibrary.GetRecentlyAddedMovies", params, this, "listReceived");
-    } else {
-        QVariantMap sort;
-        sort.insert("method", "label");
-        sort.insert("order", "ascending");
-        sort.insert("ignorearticle", ignoreArticle());
-        params.insert("sort", sort);
-
-        KodiConnection::sendCommand("VideoLibrary.GetMovies", params, this, "listReceived");
+        return KodiConnection::sendCommand("VideoLibrary.GetRecentlyAddedMovies", params, this, callback);
     }
+
+    QVariantMap sort;
+    sort.insert("method", "label");
+    sort.insert("order", "ascending");
+    sort.insert("ignorearticle", ignoreArticle());
+    params.insert("sort", sort);
+
+    return KodiConnection::sendCommand("VideoLibrary.GetMovies", params, this, callback);
 }
 
-void Movies::fetchItemDetails(int index)
+QVariantList Movies::detailsProperties()
 {
-    QVariantMap params;
-    params.insert("movieid", m_list.at(index)->data(RoleMovieId).toInt());
-
     QVariantList properties;
 
 //    properties.append("title");
@@ -137,12 +121,52 @@ void Movies::fetchItemDetails(int index)
 //    properties.append("resume");
 //    properties.append("setid");
 
-    params.insert("properties", properties);
+    return properties;
+}
+
+void Movies::fetchItemDetails(int index)
+{
+    int movieId = m_list.at(index)->data(RoleMovieId).toInt();
+    if (Kodi::instance()->detailsCache()->contains("movie", movieId)) {
+        setItemDetails(index, Kodi::instance()->detailsCache()->details("movie", movieId));
+        return;
+    }
+
+    QVariantMap params;
+    params.insert("movieid", movieId);
+    params.insert("properties", detailsProperties());
 
     int id = KodiConnection::sendCommand("VideoLibrary.GetMovieDetails", params, this, "detailsReceived");
     m_detailsRequestMap.insert(id, index);
 }
 
+void Movies::prefetchItemDetails(int first, int last)
+{
+    first = qMax(0, first);
+    last = qMin(m_list.count() - 1, last);
+
+    // Only ask for the part of the range that isn't cached yet
+    KodiDetailsCache *cache = Kodi::instance()->detailsCache();
+    while (first <= last && cache->contains("movie", m_list.at(first)->data(RoleMovieId).toInt())) {
+        ++first;
+    }
+    while (last >= first && cache->contains("movie", m_list.at(last)->data(RoleMovieId).toInt())) {
+        --last;
+    }
+    if (first > last) {
+        return;
+    }
+
+    QVariantMap params;
+    params.insert("properties", detailsProperties());
+    QVariantMap limits;
+    limits.insert("start", first);
+    limits.insert("end", last + 1);
+    params.insert("limits", limits);
+
+    sendListCommand(params, "prefetchReceived");
+}
+
 void Movies::download(int index, const QString &path)
 {
     LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(index));
@@ -153,6 +177,7 @@ void Movies::download(int index, const QString &path)
     KodiDownload *download = new KodiDownload();
     download->setDestination(destination);
     download->setIconId("icon-m-content-videos");
+    download->setSegmented(true);
     download->setLabel(item->title());
 
     startDownload(index, download);
@@ -194,8 +219,23 @@ void Movies::detailsReceived(const QVariantMap &rsp)
     qDebug() << "got item details:" << rsp;
     int id = rsp.value("id").toInt();
     int row = m_detailsRequestMap.take(id);
-    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(row));
     QVariantMap details = rsp.value("result").toMap().value("moviedetails").toMap();
+    Kodi::instance()->detailsCache()->insert("movie", details.value("movieid").toInt(), details);
+    setItemDetails(row, details);
+}
+
+void Movies::prefetchReceived(const QVariantMap &rsp)
+{
+    QVariantList responseList = rsp.value("result").toMap().value("movies").toList();
+    foreach(const QVariant &itemVariant, responseList) {
+        QVariantMap details = itemVariant.toMap();
+        Kodi::instance()->detailsCache()->insert("movie", details.value("movieid").toInt(), details);
+    }
+}
+
+void Movies::setItemDetails(int row, const QVariantMap &details)
+{
+    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(row));
     item->setGenre(details.value("genre").toString());
     item->setYear(details.value("year").toString());
     item->setRating(details.value("rating").toInt());
@@ -30,6 +30,7 @@ class Movies : public KodiLibrary
     Q_OBJECT
 public:
     explicit Movies(bool recentlyAdded = false, KodiModel *parent = 0);
+    static QString cacheKey() { return QString("Movies"); }
     ~Movies();
 
     KodiModel *enterItem(int index);
@@ -39,6 +40,7 @@ public:
     QString title() const;
 
     Q_INVOKABLE void fetchItemDetails(int index);
+    Q_INVOKABLE void prefetchItemDetails(int first, int last);
     Q_INVOKABLE bool hasShortDetails() { return true; }
     Q_INVOKABLE bool hasDetails() { return true; }
 
@@ -53,9 +55,14 @@ public slots:
 private slots:
     void listReceived(const QVariantMap &rsp);
     void detailsReceived(const QVariantMap &rsp);
-    void receivedAnnouncement(const QVariantMap &map);
+    void prefetchReceived(const QVariantMap &rsp);
+    void itemUpdated(const QString &type, int id);
 
 private:
+    int sendListCommand(QVariantMap params, const QString &callback);
+    static QVariantList detailsProperties();
+    void setItemDetails(int row, const QVariantMap &details);
+
     QMap<int, int> m_detailsRequestMap;
     QMap<int, int> m_idIndexMapping;
     bool m_recentlyAdded;
@@ -25,45 +25,27 @@
 #include "videoplaylist.h"
 #include "videoplaylistitem.h"
 #include "libraryitem.h"
+#include "entitystore.h"
 
 MusicVideos::MusicVideos(bool recentlyAdded, KodiModel *parent) :
     KodiLibrary(parent),
     m_recentlyAdded(recentlyAdded)
 {
-    connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
+    if (!recentlyAdded) {
+        setCacheKey(cacheKey());
+    }
+    connect(Kodi::instance()->entityStore(), SIGNAL(itemUpdated(QString,int)), SLOT(itemUpdated(QString,int)));
 }
 
-void MusicVideos::receivedAnnouncement(const QVariantMap &map)
+void MusicVideos::itemUpdated(const QString &type, int id)
 {
-    QString method = map.value("method").toString();
-
-    if(method != "VideoLibrary.OnUpdate") {
-        return;
-    }
-
-    QVariantMap data = map.value("params").toMap().value("data").toMap();
-
-    QVariant playcount = data.value("playcount");
-    if(!playcount.isValid() || playcount.toInt() < 0) {
-        return;
-    }
-
-    QString type = data.value("item").toMap().value("type").toString();
-    int id = data.value("item").toMap().value("id").toInt();
+    // The item itself has already been updated by the entity store
     if(type != "musicvideo" || !m_idIndexMapping.contains(id)) {
         return;
     }
 
     int i = m_idIndexMapping.value(id);
-    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(i));
-
-    if(playcount.toInt() == item->playcount()) {
-        return;
-    }
-
-
-    item->setPlaycount(playcount.toInt());
-    dataChanged(index(i, 0, QModelIndex()), index(i, 0, QModelIndex()));
+    emit dataChanged(index(i, 0, QModelIndex()), index(i, 0, QModelIndex()));
 }
 
 void MusicVideos::refresh()
@@ -30,6 +30,7 @@ class MusicVideos : public KodiLibrary
     Q_OBJECT
 public:
     explicit MusicVideos(bool recentlyAdded, KodiModel *parent = 0);
+    static QString cacheKey() { return QString("MusicVideos"); }
 
     KodiModel *enterItem(int index);
     void playItem(int index);
@@ -46,7 +47,7 @@ public slots:
 private slots:
     void listReceived(const QVariantMap &rsp);
     void detailsReceived(const QVariantMap &rsp);
-    void receivedAnnouncement(const QVariantMap &map);
+    void itemUpdated(const QString &type, int id);
 
 private:
     QMap<int, int> m_detailsRequestMap;
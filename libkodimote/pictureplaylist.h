@@ -35,6 +35,12 @@ public:
     int playlistId() const { return 2; }
     void refresh() {}
     void queryItemData(int) {}
+    QVariantList itemProperties() const { return QVariantList(); }
+    void insertItems(int, int) {}
+    void removeItems(int, int) {}
+    void clearItems() {}
+    void setItemData(int, const QVariantList &) {}
+    void releaseItems(int, int) {}
 
 private slots:
     void receivedAnnouncement(const QVariantMap &map);
@@ -24,11 +24,20 @@
 
 #include "kodiconnection.h"
 #include "kodi.h"
+#include "imagecache.h"
 
 #include "kodebug.h"
 
 #include <QTime>
 
+// The play time is resynced with the server more often while it drifts and
+// less often while the interpolation holds up
+static const int minResyncInterval = 2000;
+static const int maxResyncInterval = 30000;
+static const int driftTolerance = 150;
+// Samples taking longer than this (ms) can't tell drift from network delay
+static const int maxResyncRoundTrip = 500;
+
 Player::Player(PlayerType type, QObject *parent) :
     QObject(parent),
     m_type(type),
@@ -36,19 +45,33 @@ Player::Player(PlayerType type, QObject *parent) :
     m_speed(1),
     m_percentage(0),
     m_lastPlaytime(0),
-    m_lastPlaytimeUpdate(QDateTime::currentDateTime()),
+    m_samplePlaytime(0),
+    m_tickRate(1),
+    m_drift(0),
+    m_syncPending(0),
+    m_syncLatency(0),
     m_currentItem(new LibraryItem(this)),
     m_seeking(false),
+    m_timerActivated(false),
     m_shuffle(false),
     m_repeat(RepeatNone),
     m_currentSubtitle(-1),
-    m_currentAudiostream(0)
+    m_currentAudiostream(0),
+    m_prefetchPosition(-1)
 {
     qDebug() << "player created libraryItem" << m_currentItem << m_currentItem->rating();
     connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
 
+    m_sampleClock.invalidate();
+    m_resyncRequestClock.invalidate();
+    m_syncClock.invalidate();
+
     m_playtimeTimer.setInterval(1000);
     connect(&m_playtimeTimer, SIGNAL(timeout()), SLOT(updatePlaytime()));
+
+    m_resyncTimer.setSingleShot(true);
+    m_resyncTimer.setInterval(minResyncInterval);
+    connect(&m_resyncTimer, SIGNAL(timeout()), SLOT(resyncPlaytime()));
 }
 
 void Player::getSpeed()
@@ -107,11 +130,8 @@ void Player::getMediaProps()
     KodiConnection::sendCommand("Player.GetProperties", params, this, "mediaPropsReceived");
 }
 
-void Player::getCurrentItemDetails()
+QVariantList Player::itemProperties()
 {
-    QVariantMap params;
-    params.insert("playerid", playerId());
-
     QVariantList properties;
     properties.append("title");
     properties.append("artist");
@@ -142,14 +162,85 @@ void Player::getCurrentItemDetails()
 //    properties.append("description");
     properties.append("thumbnail");
     properties.append("runtime");
-    params.insert("properties", properties);
+    return properties;
+}
+
+void Player::getCurrentItemDetails()
+{
+    QVariantMap params;
+    params.insert("playerid", playerId());
+    params.insert("properties", itemProperties());
 
     KodiConnection::sendCommand("Player.GetItem", params, this, "detailsReceived");
 }
 
+void Player::prefetchNeighbours(int position)
+{
+    if(position < 0 || position == m_prefetchPosition) {
+        return;
+    }
+    m_prefetchPosition = position;
+
+    // Fetch the previous and next entries along with the current one so skipping
+    // in either direction finds its details and large artwork already in place.
+    QVariantMap params;
+    params.insert("playlistid", playlist()->playlistId());
+    params.insert("properties", itemProperties());
+    QVariantMap limits;
+    limits.insert("start", qMax(0, position - 1));
+    limits.insert("end", position + 2);
+    params.insert("limits", limits);
+
+    KodiConnection::sendCommand("Playlist.GetItems", params, this, "neighboursReceived");
+}
+
+void Player::neighboursReceived(const QVariantMap &rsp)
+{
+    koDebug(XDAREA_PLAYER) << "got neighbouring items" << rsp;
+    m_prefetchedItems.clear();
+    foreach(const QVariant &itemVariant, rsp.value("result").toMap().value("items").toList()) {
+        QVariantMap itemMap = itemVariant.toMap();
+        if(itemMap.contains("id")) {
+            m_prefetchedItems.insert(prefetchKey(itemMap.value("type").toString(), itemMap.value("id").toInt()), itemMap);
+        }
+        prefetchImage(itemMap.value("thumbnail").toString());
+        prefetchImage(itemMap.value("fanart").toString());
+    }
+}
+
+void Player::prefetchImage(const QString &image)
+{
+    if(image.isEmpty()) {
+        return;
+    }
+    KodiImageCache *imageCache = Kodi::instance()->imageCache();
+    QString cachedFile;
+    if(!imageCache->contains(image, KodiImageCache::CacheLarge, cachedFile)) {
+        imageCache->fetch(image, this, "prefetchedImageFetched", KodiImageCache::cacheSize(KodiImageCache::CacheLarge), KodiImageCache::CacheLarge);
+    }
+}
+
+void Player::prefetchedImageFetched(int id)
+{
+    // Nothing to do, the image is in the cache when the item starts playing
+    Q_UNUSED(id)
+}
+
+QString Player::prefetchKey(const QString &type, int id)
+{
+    return type + QLatin1Char(':') + QString::number(id);
+}
+
 void Player::refresh()
 {
     koDebug(XDAREA_PLAYER) << "player" << playerId() << "refreshing";
+    syncState();
+    playlist()->refresh();
+}
+
+void Player::syncState()
+{
+    // Everything in one go, refreshReceived only emits what actually changed
     QVariantMap params;
     params.insert("playerid", playerId());
     QVariantList props;
@@ -160,19 +251,37 @@ void Player::refresh()
     props.append("shuffled");
     props.append("subtitles");
     props.append("currentsubtitle");
+    props.append("subtitleenabled");
     props.append("audiostreams");
     props.append("currentaudiostream");
     params.insert("properties", props);
+    m_syncPending = 2;
     KodiConnection::sendCommand("Player.GetProperties", params, this, "refreshReceived");
     getCurrentItemDetails();
-    playlist()->refresh();
+}
+
+void Player::syncStepDone()
+{
+    if(m_syncPending == 0 || --m_syncPending > 0) {
+        return;
+    }
+    if(m_syncClock.isValid()) {
+        m_syncLatency = m_syncClock.elapsed();
+        m_syncClock.invalidate();
+        koDebug(XDAREA_PLAYER) << "player state synced" << m_syncLatency << "ms after Player.OnPlay";
+        emit syncLatencyChanged();
+    }
 }
 
 void Player::detach()
 {
     koDebug(XDAREA_PLAYER) << "stopping player";
     m_state = "stopped";
+    m_prefetchPosition = -1;
+    m_prefetchedItems.clear();
     m_playtimeTimer.stop();
+    m_resyncTimer.stop();
+    m_resyncRequestClock.invalidate();
     emit stateChanged();
     m_speed = 1;
     emit speedChanged();
@@ -253,80 +362,163 @@ void Player::receivedAnnouncement(const QVariantMap &map)
         // and thus it would already return above
         detach();
     } else if(map.value("method").toString() == "Player.OnPause") {
+        rebasePlaytime();
         m_state = "paused";
-        m_playtimeTimer.stop();
+        updateTimers();
         updatePlaytime();
         emit stateChanged();
-        m_speed = 1;
-        emit speedChanged();
+        if(m_speed != 1) {
+            m_speed = 1;
+            emit speedChanged();
+        }
     } else if(map.value("method").toString() == "Player.OnPlay") {
-        m_state = "playing";
-        emit stateChanged();
-        refresh();
-        m_speed = data.value("player").toMap().value("speed").toInt();
-        qDebug() << "set speed to" << m_speed;
-        emit speedChanged();
-        getPosition();
-        getPlaytime();
-        getCurrentItemDetails();
-        m_lastPlaytimeUpdate = QDateTime::currentDateTime();
-        if(m_timerActivated) {
-            m_playtimeTimer.start();
+        m_syncClock.start();
+        // Show what we prefetched right away, Player.GetItem will update it
+        QVariantMap item = data.value("item").toMap();
+        QString key = prefetchKey(item.value("type").toString(), item.value("id").toInt());
+        if(m_prefetchedItems.contains(key)) {
+            setCurrentItemDetails(m_prefetchedItems.value(key));
+        }
+        rebasePlaytime();
+        if(m_state != "playing") {
+            m_state = "playing";
+            emit stateChanged();
+        }
+        int speed = data.value("player").toMap().value("speed").toInt();
+        if(m_speed != speed) {
+            m_speed = speed;
+            qDebug() << "set speed to" << m_speed;
+            emit speedChanged();
         }
-        playlist()->refresh();
+        syncState();
+        updateTimers();
     } else if(map.value("method").toString() == "Player.OnSeek") {
         updatePlaytime(data.value("player").toMap().value("time").toMap());
+        m_resyncTimer.setInterval(minResyncInterval);
         m_seeking = false;
     } else if(map.value("method").toString() == "Player.OnSpeedChanged") {
-        updatePlaytime();
+        rebasePlaytime();
         m_speed = data.value("player").toMap().value("speed").toInt();
         emit speedChanged();
+        updatePlaytime();
     }
 }
 
 void Player::speedReceived(const QVariantMap &rsp)
 {
-    m_speed = rsp.value("result").toMap().value("speed").toInt();
-    koDebug(XDAREA_PLAYER) << "got player speed" << m_speed;
-    emit speedChanged();
+    int speed = rsp.value("result").toMap().value("speed").toInt();
+    koDebug(XDAREA_PLAYER) << "got player speed" << speed;
 
-    if(m_speed == 0) {
-        m_state = "paused";
-    } else {
-        m_state = "playing";
+    rebasePlaytime();
+    if(m_speed != speed) {
+        m_speed = speed;
+        emit speedChanged();
     }
-    emit stateChanged();
+
+    QString state = m_speed == 0 ? "paused" : "playing";
+    if(m_state != state) {
+        m_state = state;
+        emit stateChanged();
+    }
+    updateTimers();
 }
 
 void Player::playtimeReceived(const QVariantMap &rsp)
 {
     koDebug(XDAREA_PLAYER) << "Got playtime response" << rsp;
     updatePlaytime(rsp.value("result").toMap().value("time").toMap());
-    if (m_timerActivated && !m_playtimeTimer.isActive()) {
-        m_playtimeTimer.start();
+    updateTimers();
+}
+
+void Player::resyncPlaytime()
+{
+    if(m_resyncRequestClock.isValid()) {
+        // Still waiting for the last one
+        return;
     }
+
+    QVariantMap params;
+    params.insert("playerid", playerId());
+    QVariantList props;
+    props.append("time");
+    params.insert("properties", props);
+    // Bypass the command queue. Time spent waiting in there would count as round trip.
+    m_resyncRequestClock.start();
+    if(KodiConnection::sendParallelCommand("Player.GetProperties", params, this, "resyncReceived") < 0) {
+        m_resyncRequestClock.invalidate();
+    }
+}
+
+void Player::resyncReceived(const QVariantMap &rsp)
+{
+    if(!m_resyncRequestClock.isValid()) {
+        // Detached in the meantime
+        return;
+    }
+    int roundTrip = m_resyncRequestClock.elapsed();
+    m_resyncRequestClock.invalidate();
+
+    if(rsp.contains("error") || m_seeking) {
+        updateTimers();
+        return;
+    }
+    if(roundTrip > maxResyncRoundTrip) {
+        koDebug(XDAREA_PLAYER) << "dropping play time sample, round trip" << roundTrip << "ms";
+        m_resyncTimer.setInterval(minResyncInterval);
+        updateTimers();
+        return;
+    }
+
+    // The server sampled its time about half way through the round trip
+    int playtime = parsePlaytime(rsp.value("result").toMap().value("time").toMap());
+    if(m_state == "playing") {
+        playtime += roundTrip / 2 * m_speed;
+    }
+    m_drift = playtime - interpolatedPlaytime();
+    koDebug(XDAREA_PLAYER) << "play time drift" << m_drift << "ms, round trip" << roundTrip << "ms";
+    emit driftChanged();
+
+    if(qAbs(m_drift) > driftTolerance) {
+        m_resyncTimer.setInterval(minResyncInterval);
+    } else {
+        m_resyncTimer.setInterval(qMin(m_resyncTimer.interval() * 2, maxResyncInterval));
+    }
+
+    m_samplePlaytime = playtime;
+    m_sampleClock.start();
+    updatePlaytime();
+    updateTimers();
 }
 
 void Player::positionReceived(const QVariantMap &rsp)
 {
     koDebug(XDAREA_PLAYER) << "Got position response" << rsp;
-    playlist()->setCurrentIndex(rsp.value("result").toMap().value("position").toInt());
+    int position = rsp.value("result").toMap().value("position").toInt();
+    playlist()->setCurrentIndex(position);
+    prefetchNeighbours(position);
 }
 
 void Player::repeatShuffleReceived(const QVariantMap &rsp)
 {
     QVariant result = rsp.value("result");
+    Repeat repeat;
     if(result.toMap().value("repeat").toString() == "off") {
-        m_repeat = RepeatNone;
+        repeat = RepeatNone;
     } else if(result.toMap().value("repeat").toString() == "one") {
-        m_repeat = RepeatOne;
+        repeat = RepeatOne;
     } else {
-        m_repeat = RepeatAll;
+        repeat = RepeatAll;
+    }
+    if(m_repeat != repeat) {
+        m_repeat = repeat;
+        emit repeatChanged();
     }
-    emit repeatChanged();
 
-    m_shuffle = result.toMap().value("shuffled").toBool();
-    emit shuffleChanged();
+    bool shuffle = result.toMap().value("shuffled").toBool();
+    if(m_shuffle != shuffle) {
+        m_shuffle = shuffle;
+        emit shuffleChanged();
+    }
 }
 
 void Player::mediaPropsReceived(const QVariantMap &rsp)
@@ -334,7 +526,7 @@ void Player::mediaPropsReceived(const QVariantMap &rsp)
     QVariant result = rsp.value("result");
 
     QVariantList subtitleList = result.toMap().value("subtitles").toList();
-    m_subtitles.clear();
+    QStringList subtitles;
     foreach (const QVariant &sub, subtitleList) {
         QString label;
         if (!sub.toMap().value("language").toString().isEmpty()) {
@@ -342,33 +534,43 @@ void Player::mediaPropsReceived(const QVariantMap &rsp)
         } else {
             label = sub.toMap().value("name").toString();
         }
-        m_subtitles.append(label);
+        subtitles.append(label);
+    }
+    if(m_subtitles != subtitles) {
+        m_subtitles = subtitles;
+        koDebug(XDAREA_PLAYER) << "got subtitles:" << m_subtitles;
+        emit subtitlesChanged();
     }
 
-    m_currentSubtitle = result.toMap().value("currentsubtitle").toMap().value("index").toInt();
+    int currentSubtitle = result.toMap().value("currentsubtitle").toMap().value("index").toInt();
     if (!result.toMap().value("subtitleenabled").toBool()) {
-        m_currentSubtitle = -1;
+        currentSubtitle = -1;
+    }
+    if(m_currentSubtitle != currentSubtitle) {
+        m_currentSubtitle = currentSubtitle;
+        emit currentSubtitleChanged();
     }
-
-    koDebug(XDAREA_PLAYER) << "got subtitles:" << m_subtitles;
-    emit subtitlesChanged();
-    emit currentSubtitleChanged();
 
     QVariantList audiostreamList = result.toMap().value("audiostreams").toList();
-    m_audiostreams.clear();
+    QStringList audiostreams;
     foreach (const QVariant &as, audiostreamList) {
         QString label = as.toMap().value("name").toString();
         if (!as.toMap().value("language").toString().isEmpty()) {
             label += " - " + as.toMap().value("language").toString();
         }
-        m_audiostreams.append(label);
+        audiostreams.append(label);
+    }
+    if(m_audiostreams != audiostreams) {
+        m_audiostreams = audiostreams;
+        koDebug(XDAREA_PLAYER) << "got audiostreams:" << m_audiostreams;
+        emit audiostreamsChanged();
     }
 
-    m_currentAudiostream = result.toMap().value("currentaudiostream").toMap().value("index").toInt();
-
-    koDebug(XDAREA_PLAYER) << "got audiostreams:" << m_subtitles;
-    emit audiostreamsChanged();
-    emit currentAudiostreamChanged();
+    int currentAudiostream = result.toMap().value("currentaudiostream").toMap().value("index").toInt();
+    if(m_currentAudiostream != currentAudiostream) {
+        m_currentAudiostream = currentAudiostream;
+        emit currentAudiostreamChanged();
+    }
 }
 
 void Player::refreshReceived(const QVariantMap &rsp)
@@ -378,12 +580,23 @@ void Player::refreshReceived(const QVariantMap &rsp)
     positionReceived(rsp);
     repeatShuffleReceived(rsp);
     mediaPropsReceived(rsp);
+    syncStepDone();
 }
 
 void Player::detailsReceived(const QVariantMap &rsp)
 {
     koDebug(XDAREA_PLAYER) << "got current item details:" << rsp;
-    QVariantMap itemMap = rsp.value("result").toMap().value("item").toMap();
+    setCurrentItemDetails(rsp.value("result").toMap().value("item").toMap());
+    syncStepDone();
+}
+
+void Player::setCurrentItemDetails(const QVariantMap &itemMap)
+{
+    if(itemMap == m_currentItemDetails) {
+        // Most likely what we already prefetched
+        return;
+    }
+    m_currentItemDetails = itemMap;
 
     if(m_currentItem) {
         m_currentItem->deleteLater();
@@ -494,34 +707,84 @@ void Player::updatePlaytime()
 
     //use milliseconds, otherwise it tends to skip a sec. once in a while
     int duration = QTime(0, 0, 0).msecsTo(m_currentItem->duration());
-    QDateTime currentTime = QDateTime::currentDateTime();
-    int elapsedMSeconds = m_lastPlaytimeUpdate.msecsTo(currentTime);
-    m_lastPlaytime += elapsedMSeconds * m_speed;
-    m_percentage = qMax(0.0, qMin(100.0, (double)m_lastPlaytime / duration * 100));
-    m_lastPlaytimeUpdate = currentTime;
+    int lastPlaytime = m_lastPlaytime;
+    m_lastPlaytime = interpolatedPlaytime();
+    double percentage = m_percentage;
+    if(duration > 0) {
+        m_percentage = qMax(0.0, qMin(100.0, (double)m_lastPlaytime / duration * 100));
+    }
 
-    emit percentageChanged();
-    emit timeChanged();
+    if(m_percentage != percentage) {
+        emit percentageChanged();
+    }
+    // time() only shows full seconds
+    if(m_lastPlaytime / 1000 != lastPlaytime / 1000) {
+        emit timeChanged();
+    }
 }
 
 void Player::updatePlaytime(const QVariantMap &timeMap)
 {
-    QDateTime currentTime = QDateTime::currentDateTime();
+    m_samplePlaytime = parsePlaytime(timeMap);
+    m_sampleClock.start();
+    updatePlaytime();
+}
+
+int Player::parsePlaytime(const QVariantMap &timeMap)
+{
     QTime time;
     int hours = timeMap.value("hours").toInt();
     int minutes = timeMap.value("minutes").toInt();
     int seconds = timeMap.value("seconds").toInt();
     int mseconds = timeMap.value("milliseconds").toInt();
     time.setHMS(hours, minutes, seconds, mseconds);
-    m_lastPlaytime = QTime(0, 0, 0).msecsTo(time);
-    m_lastPlaytimeUpdate = currentTime;
-    if(playlist()->currentItem()) {
-        int duration = QTime(0, 0, 0).msecsTo(playlist()->currentItem()->duration());
-        m_percentage = (double)m_lastPlaytime / duration * 100;
-        emit percentageChanged();
+    return QTime(0, 0, 0).msecsTo(time);
+}
+
+int Player::interpolatedPlaytime() const
+{
+    qint64 playtime = m_samplePlaytime;
+    if(m_state == "playing" && m_sampleClock.isValid()) {
+        // Monotonic, unlike the wall clock which jumps with NTP or time zone changes
+        playtime += m_sampleClock.elapsed() * m_speed;
+    }
+    int duration = m_currentItem ? QTime(0, 0, 0).msecsTo(m_currentItem->duration()) : 0;
+    if(duration > 0) {
+        playtime = qMin(playtime, (qint64)duration);
+    }
+    return qMax((qint64)0, playtime);
+}
+
+void Player::rebasePlaytime()
+{
+    m_samplePlaytime = interpolatedPlaytime();
+    m_sampleClock.start();
+}
+
+void Player::updateTimers()
+{
+    bool running = m_timerActivated && m_state == "playing";
+
+    if(running && m_tickRate > 0) {
+        if(m_playtimeTimer.interval() != 1000 / m_tickRate) {
+            m_playtimeTimer.setInterval(1000 / m_tickRate);
+        }
+        if(!m_playtimeTimer.isActive()) {
+            m_playtimeTimer.start();
+        }
+    } else {
+        m_playtimeTimer.stop();
     }
 
-    emit timeChanged();
+    // Nobody looks at the play time when the ticks are off, no need to resync either
+    if(running && m_tickRate > 0) {
+        if(!m_resyncTimer.isActive() && !m_resyncRequestClock.isValid()) {
+            m_resyncTimer.start();
+        }
+    } else {
+        m_resyncTimer.stop();
+        m_resyncTimer.setInterval(minResyncInterval);
+    }
 }
 
 void Player::playItem(int index)
@@ -631,26 +894,47 @@ Player::Repeat Player::repeat() const
 
 bool Player::timerActive() const
 {
-    return m_playtimeTimer.isActive();
+    return m_timerActivated;
 }
 
 void Player::setTimerActive(bool active)
 {
-    if(m_playtimeTimer.isActive() == active) {
+    if(m_timerActivated == active) {
         return;
     }
 
     m_timerActivated = active;
-
-    if(active) {
-        if(m_state == "playing") {
-            m_playtimeTimer.start();
-            updatePlaytime();
-        }
+    updateTimers();
+    if(active && m_state == "playing") {
+        updatePlaytime();
     }
-    else {
-        m_playtimeTimer.stop();
+}
+
+int Player::tickRate() const
+{
+    return m_tickRate;
+}
+
+void Player::setTickRate(int tickRate)
+{
+    tickRate = qBound(0, tickRate, 60);
+    if(m_tickRate == tickRate) {
+        return;
     }
+
+    m_tickRate = tickRate;
+    emit tickRateChanged();
+    updateTimers();
+}
+
+int Player::drift() const
+{
+    return m_drift;
+}
+
+int Player::syncLatency() const
+{
+    return m_syncLatency;
 }
 
 void Player::seek(double percentage)
@@ -24,8 +24,9 @@
 #include <QObject>
 #include <QVariantMap>
 #include <QTimer>
-#include <QDateTime>
+#include <QElapsedTimer>
 #include <QStringList>
+#include <QHash>
 
 class Playlist;
 class LibraryItem;
@@ -43,6 +44,12 @@ class Player : public QObject
     Q_PROPERTY(double percentage READ percentage NOTIFY percentageChanged)
     Q_PROPERTY(QString time READ time NOTIFY timeChanged)
     Q_PROPERTY(bool timerActive READ timerActive WRITE setTimerActive)
+    /** How often time and percentage are updated while playing, in Hz. 0 stops the updates */
+    Q_PROPERTY(int tickRate READ tickRate WRITE setTickRate NOTIFY tickRateChanged)
+    /** Difference between the interpolated and the actual play time at the last resync, in ms */
+    Q_PROPERTY(int drift READ drift NOTIFY driftChanged)
+    /** Time from the last Player.OnPlay until the whole player state was updated, in ms */
+    Q_PROPERTY(int syncLatency READ syncLatency NOTIFY syncLatencyChanged)
     Q_PROPERTY(bool shuffle READ shuffle WRITE setShuffle NOTIFY shuffleChanged)
     Q_PROPERTY(Repeat repeat READ repeat WRITE setRepeat NOTIFY repeatChanged)
     Q_PROPERTY(QStringList subtitles READ subtitles NOTIFY subtitlesChanged)
@@ -104,6 +111,12 @@ public:
     bool timerActive() const;
     void setTimerActive(bool active);
 
+    int tickRate() const;
+    void setTickRate(int tickRate);
+
+    int drift() const;
+    int syncLatency() const;
+
     Q_INVOKABLE void seek(double percentage);
 
     LibraryItem* currentItem() const;
@@ -121,6 +134,9 @@ signals:
     void currentSubtitleChanged();
     void audiostreamsChanged();
     void currentAudiostreamChanged();
+    void tickRateChanged();
+    void driftChanged();
+    void syncLatencyChanged();
 
 public slots:
     void playPause();
@@ -136,21 +152,37 @@ private slots:
     void getPosition();
     void receivedAnnouncement(const QVariantMap& map);
     void updatePlaytime();
+    void resyncPlaytime();
     void getRepeatShuffle();
     void getMediaProps();
 
     void getCurrentItemDetails();
+    void prefetchNeighbours(int position);
 
     void speedReceived(const QVariantMap &rsp);
     void playtimeReceived(const QVariantMap &rsp);
+    void resyncReceived(const QVariantMap &rsp);
     void positionReceived(const QVariantMap &rsp);
     void repeatShuffleReceived(const QVariantMap &rsp);
     void detailsReceived(const QVariantMap &rsp);
     void refreshReceived(const QVariantMap &rsp);
     void mediaPropsReceived(const QVariantMap &rsp);
+    void neighboursReceived(const QVariantMap &rsp);
+    void prefetchedImageFetched(int id);
 
 private:
+    static QVariantList itemProperties();
+    static QString prefetchKey(const QString &type, int id);
+    static int parsePlaytime(const QVariantMap &time);
+
     void updatePlaytime(const QVariantMap &time);
+    int interpolatedPlaytime() const;
+    void rebasePlaytime();
+    void updateTimers();
+    void syncState();
+    void syncStepDone();
+    void setCurrentItemDetails(const QVariantMap &itemMap);
+    void prefetchImage(const QString &image);
 
 protected:
     PlayerType m_type;
@@ -159,7 +191,19 @@ protected:
     double m_percentage;
     QTimer m_playtimeTimer;
     int m_lastPlaytime;
-    QDateTime m_lastPlaytimeUpdate;
+
+    // Play time reported by the server and the monotonic time since we got it
+    int m_samplePlaytime;
+    QElapsedTimer m_sampleClock;
+    QTimer m_resyncTimer;
+    QElapsedTimer m_resyncRequestClock;
+    int m_tickRate;
+    int m_drift;
+
+    QVariantMap m_currentItemDetails;
+    QElapsedTimer m_syncClock;
+    int m_syncPending;
+    int m_syncLatency;
     LibraryItem* m_currentItem;
     bool m_seeking;
     bool m_timerActivated;
@@ -170,6 +214,10 @@ protected:
     int m_currentSubtitle;
     QStringList m_audiostreams;
     int m_currentAudiostream;
+
+    // Details of the playlist entries around the current one, keyed by type and id
+    QHash<QString, QVariantMap> m_prefetchedItems;
+    int m_prefetchPosition;
 };
 
 #endif // PLAYER_H
@@ -24,12 +24,27 @@
 #include "kodiconnection.h"
 #include "kodebug.h"
 
+static const int pageSize = 100;
+static const int maxLoadedPages = 10;
+
 Playlist::Playlist(Player *parent) :
     KodiModel(parent),
     m_currentItem(-1),
-    m_player(parent)
+    m_player(parent),
+    m_current(0),
+    m_currentRow(-1),
+    m_lastRequestedRow(0),
+    m_refreshRequest(-1)
 {
     connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
+
+    // Views ask for one row after the other while scrolling, collect them into pages
+    m_fetchTimer.setSingleShot(true);
+    m_fetchTimer.setInterval(50);
+    connect(&m_fetchTimer, SIGNAL(timeout()), SLOT(fetchWantedPages()));
+
+    // Rows exist as soon as the count is known, items are fetched on demand
+    setBusy(false);
 }
 
 Player *Playlist::player() const
@@ -44,8 +59,6 @@ void Playlist::addItems(const PlaylistItem &item)
     params.insert("playlistid", playlistId());
 
     KodiConnection::sendCommand("Playlist.Add", params);
-
-    refresh();
 }
 
 void Playlist::removeItem(int index)
@@ -54,8 +67,6 @@ void Playlist::removeItem(int index)
     params.insert("position", index);
     params.insert("playlistid", playlistId());
     KodiConnection::sendCommand("Playlist.Remove", params);
-
-    refresh();
 }
 
 void Playlist::clear()
@@ -63,7 +74,6 @@ void Playlist::clear()
     QVariantMap params;
     params.insert("playlistid", playlistId());
     KodiConnection::sendCommand("Playlist.Clear", params);
-    refresh();
 }
 
 void Playlist::addPlaylist(const QString &playlist)
@@ -76,7 +86,6 @@ void Playlist::addPlaylist(const QString &playlist)
     params.insert("playlistid", playlistId());
 
     KodiConnection::sendCommand("Playlist.Add", params);
-    refresh();
 }
 
 void Playlist::addFile(const QString &file)
@@ -89,7 +98,6 @@ void Playlist::addFile(const QString &file)
     params.insert("playlistid", playlistId());
 
     KodiConnection::sendCommand("Playlist.Add", params);
-    refresh();
 }
 
 void Playlist::addDirectory(const QString &dir)
@@ -102,12 +110,233 @@ void Playlist::addDirectory(const QString &dir)
     params.insert("playlistid", playlistId());
 
     KodiConnection::sendCommand("Playlist.Add", params);
-    refresh();
+}
+
+void Playlist::refresh()
+{
+    koDebug(XDAREA_PLAYLIST) << "Refreshing playlist" << playlistId();
+    m_fetchTimer.stop();
+    m_wantedPages.clear();
+    m_pendingPages.clear();
+    m_fetchRequests.clear();
+
+    // Start with the page around the current item, views request the rest as they scroll
+    m_refreshRequest = fetchPage(qMax(0, m_currentItem) / pageSize);
+}
+
+void Playlist::requestItem(int row) const
+{
+    m_lastRequestedRow = row;
+    int page = row / pageSize;
+    if(!m_pendingPages.contains(page)) {
+        m_wantedPages.insert(page);
+        if(!m_fetchTimer.isActive()) {
+            m_fetchTimer.start();
+        }
+    }
+}
+
+bool Playlist::itemTitle(int row, QString &title) const
+{
+    // Searching through the playlist must not load all of it
+    PlaylistItem *item = at(row);
+    if(!item) {
+        return false;
+    }
+    title = item->label();
+    return true;
+}
+
+void Playlist::fetchWantedPages()
+{
+    foreach(int page, m_wantedPages) {
+        if(!m_pendingPages.contains(page) && page * pageSize < count()) {
+            fetchPage(page);
+        }
+    }
+    m_wantedPages.clear();
+}
+
+int Playlist::fetchPage(int page)
+{
+    QVariantMap params;
+    params.insert("playlistid", playlistId());
+    params.insert("properties", itemProperties());
+    QVariantMap limits;
+    limits.insert("start", page * pageSize);
+    limits.insert("end", (page + 1) * pageSize);
+    params.insert("limits", limits);
+
+    int id = KodiConnection::sendCommand("Playlist.GetItems", params, this, "pageReceived");
+    m_fetchRequests.insert(id, page);
+    m_pendingPages.insert(page);
+    return id;
+}
+
+void Playlist::pageReceived(const QVariantMap &rsp)
+{
+    int id = rsp.value("id").toInt();
+    if(!m_fetchRequests.contains(id)) {
+        // Sent before the last refresh
+        return;
+    }
+    int page = m_fetchRequests.take(id);
+    m_pendingPages.remove(page);
+    bool refreshed = id == m_refreshRequest;
+    if(refreshed) {
+        m_refreshRequest = -1;
+    }
+
+    QVariantMap result = rsp.value("result").toMap();
+    int total = result.value("limits").toMap().value("total").toInt();
+    if(rsp.contains("error")) {
+        koDebug(XDAREA_PLAYLIST) << "Failed to fetch playlist page" << page << rsp.value("error");
+        if(refreshed && page > 0) {
+            // Our idea of the current item was off, start from the top
+            m_refreshRequest = fetchPage(0);
+        } else if(!refreshed) {
+            refresh();
+        }
+        return;
+    }
+
+    if(refreshed) {
+        if(total != count()) {
+            m_currentRow = -1;
+            clearItems();
+            if(total > 0) {
+                insertItems(0, total);
+            }
+            emit countChanged();
+        } else {
+            releaseItems(0, count());
+        }
+        m_loadedPages.clear();
+    } else if(total != count()) {
+        // Responses and announcements arrive in order, so by now we must look
+        // exactly like the server did when it handled the request
+        koDebug(XDAREA_PLAYLIST) << "Playlist out of sync, have" << count() << "items, server has" << total;
+        refresh();
+        return;
+    }
+
+    QVariantList items = result.value("items").toList();
+    int start = page * pageSize;
+    setItemData(start, items);
+    m_loadedPages.insert(page);
+    evictPages();
+
+    if(m_currentItem >= start && m_currentItem < start + items.count()) {
+        queryItemData(m_currentItem);
+    }
+}
+
+void Playlist::evictPages()
+{
+    // Drop the pages furthest away from where the views look, but keep the current item
+    int currentPage = m_currentItem / pageSize;
+    int lastRequestedPage = m_lastRequestedRow / pageSize;
+    while(m_loadedPages.count() > maxLoadedPages) {
+        int evict = -1;
+        foreach(int page, m_loadedPages) {
+            if(page != currentPage && (evict < 0 || qAbs(page - lastRequestedPage) > qAbs(evict - lastRequestedPage))) {
+                evict = page;
+            }
+        }
+        if(evict < 0) {
+            break;
+        }
+        m_loadedPages.remove(evict);
+        releaseItems(qMin(evict * pageSize, count()), qMin((evict + 1) * pageSize, count()));
+    }
+}
+
+void Playlist::shiftLoadedPages(int position, int delta)
+{
+    // Rows after position moved by delta. Loaded pages behind it now straddle
+    // two pages, count both so the eviction still sees every loaded row.
+    int firstPage = position / pageSize;
+    QSet<int> loadedPages;
+    foreach(int page, m_loadedPages) {
+        if(page < firstPage) {
+            loadedPages.insert(page);
+            continue;
+        }
+        int start = qMax(page * pageSize + delta, position);
+        int end = (page + 1) * pageSize + delta;
+        for(int touched = start / pageSize; touched * pageSize < qMin(end, count()); ++touched) {
+            loadedPages.insert(touched);
+        }
+    }
+    m_loadedPages = loadedPages;
+    evictPages();
 }
 
 void Playlist::receivedAnnouncement(const QVariantMap &map)
 {
-    Q_UNUSED(map)
+    QString method = map.value("method").toString();
+    if(!method.startsWith("Playlist.")) {
+        return;
+    }
+    QVariantMap data = map.value("params").toMap().value("data").toMap();
+    if(data.value("playlistid").toInt() != playlistId()) {
+        return;
+    }
+    koDebug(XDAREA_PLAYLIST) << "Playlist" << playlistId() << "got announcement:" << method << data;
+
+    if(method == "Playlist.OnClear") {
+        m_wantedPages.clear();
+        m_loadedPages.clear();
+        m_currentRow = -1;
+        clearItems();
+        m_currentItem = -1;
+        emit countChanged();
+        emit currentChanged();
+        return;
+    }
+
+    if(!data.contains("position")) {
+        refresh();
+        return;
+    }
+    int position = data.value("position").toInt();
+
+    if(method == "Playlist.OnAdd") {
+        if(position < 0 || position > count()) {
+            koDebug(XDAREA_PLAYLIST) << "Playlist out of sync, item added at" << position << "but we have" << count();
+            refresh();
+            return;
+        }
+        // Views showing the new entry load it through data()
+        insertItems(position, 1);
+        if(m_currentRow >= position) {
+            m_currentRow++;
+        }
+        emit countChanged();
+        if(m_currentItem >= position) {
+            m_currentItem++;
+            emit currentChanged();
+        }
+        shiftLoadedPages(position, 1);
+    } else if(method == "Playlist.OnRemove") {
+        if(position < 0 || position >= count()) {
+            koDebug(XDAREA_PLAYLIST) << "Playlist out of sync, item removed at" << position << "but we have" << count();
+            refresh();
+            return;
+        }
+        removeItems(position, 1);
+        if(m_currentRow == position) {
+            m_currentRow = -1;
+        } else if(m_currentRow > position) {
+            m_currentRow--;
+        }
+        emit countChanged();
+        if(m_currentItem > position) {
+            m_currentItem--;
+            emit currentChanged();
+        }
+        shiftLoadedPages(position, -1);
+    }
 }
 
 int Playlist::currentTrackNumber() const
@@ -125,6 +354,10 @@ PlaylistItem* Playlist::currentItem() const
     if(m_currentItem == -1 || m_currentItem >= count()) {
         return 0;
     }
+    // The row may not be loaded, or already released with its page
+    if(m_current && m_currentRow == m_currentItem) {
+        return m_current;
+    }
     return at(m_currentItem);
 }
 
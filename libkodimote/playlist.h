@@ -27,6 +27,8 @@
 
 #include <QObject>
 #include <QVariantMap>
+#include <QTimer>
+#include <QSet>
 
 class Playlist : public KodiModel
 {
@@ -55,6 +57,7 @@ public:
     Player *player() const;
 
     PlaylistItem* currentItem() const;
+    /// returns 0 for entries that are not loaded yet
     virtual PlaylistItem* at(int index) const = 0;
 
     virtual int playlistId() const = 0;
@@ -64,19 +67,56 @@ signals:
     void currentChanged();
 
 public slots:
-    virtual void refresh() = 0;
+    virtual void refresh();
 //    void playItem(int index);
     void setCurrentIndex(int index);
 
 private slots:
     void receivedAnnouncement(const QVariantMap &map);
+    void fetchWantedPages();
+    void pageReceived(const QVariantMap &rsp);
 
 protected:
 
     virtual void queryItemData(int index) = 0;
 
+    /// request the page containing row, for data() to call on entries that are not loaded
+    void requestItem(int row) const;
+
+    bool itemTitle(int row, QString &title) const;
+
+    // Only pages of the playlist are loaded, kept in sync with the Playlist.On* announcements
+    virtual QVariantList itemProperties() const = 0;
+    /// insert count entries at position that are not loaded yet
+    virtual void insertItems(int position, int count) = 0;
+    virtual void removeItems(int position, int count) = 0;
+    virtual void clearItems() = 0;
+    /// load the items starting at position from a Playlist.GetItems result
+    virtual void setItemData(int position, const QVariantList &items) = 0;
+    /// unload the items from start up to end to free memory
+    virtual void releaseItems(int start, int end) = 0;
+
     mutable int m_currentItem;
     Player *m_player;
+
+    // Details of the current item as fetched by queryItemData(). Unlike the rows
+    // it doesn't get released with its page, so currentItem() always has it.
+    PlaylistItem *m_current;
+    // Row m_current belongs to, -1 if it's outdated
+    int m_currentRow;
+
+private:
+    int fetchPage(int page);
+    void evictPages();
+    void shiftLoadedPages(int position, int delta);
+
+    QSet<int> m_loadedPages;
+    QSet<int> m_pendingPages;
+    mutable QSet<int> m_wantedPages;
+    mutable int m_lastRequestedRow;
+    mutable QTimer m_fetchTimer;
+    QMap<int, int> m_fetchRequests;
+    int m_refreshRequest;
 };
 
 #endif // PLAYLIST_H
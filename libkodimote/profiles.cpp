@@ -115,6 +115,7 @@ void Profiles::listReceived(const QVariantMap &rsp)
     }
 
     beginResetModel();
+    qDeleteAll(m_list);
     m_list = list;
     endResetModel();
     setBusy(false);
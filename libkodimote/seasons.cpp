@@ -26,12 +26,14 @@
 #include "videoplaylist.h"
 #include "videoplaylistitem.h"
 #include "libraryitem.h"
+#include "kodidownloadjob.h"
 
 Seasons::Seasons(int tvshowid, KodiModel *parent):
     KodiLibrary(parent),
     m_tvshowid(tvshowid),
     m_refreshing(false)
 {
+    setCacheKey(cacheKey(tvshowid));
     connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
 }
 
@@ -153,7 +155,12 @@ void Seasons::seasonDetailsReceived(const QVariantMap &rsp)
 
 KodiModel *Seasons::enterItem(int index)
 {
-    return new Episodes(m_tvshowid, m_list.at(index)->data(RoleSeason).toInt(), m_list.at(index)->title(), this);
+    int season = m_list.at(index)->data(RoleSeason).toInt();
+    KodiModel *model = cachedModel(Episodes::cacheKey(m_tvshowid, season));
+    if (!model) {
+        model = new Episodes(m_tvshowid, season, m_list.at(index)->title(), this);
+    }
+    return model;
 }
 
 void Seasons::playItem(int index)
@@ -173,6 +180,13 @@ QString Seasons::title() const
     return tr("Seasons");
 }
 
+void Seasons::download(int index, const QString &path)
+{
+    qDebug() << "Downloading season";
+    KodiDownloadJob *job = new KodiDownloadJob(path, m_list.at(index)->title());
+    job->downloadSeason(m_tvshowid, m_list.at(index)->data(RoleSeason).toInt());
+}
+
 void Seasons::fetchItemDetails(int index)
 {
     QVariantMap params;
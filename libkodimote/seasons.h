@@ -30,6 +30,7 @@ class Seasons : public KodiLibrary
     Q_OBJECT
 public:
     explicit Seasons(int tvhsowId = -1, KodiModel *parent = 0);
+    static QString cacheKey(int tvshowId) { return QString("Seasons/%1").arg(tvshowId); }
 
     KodiModel *enterItem(int index);
     void playItem(int index);
@@ -40,6 +41,8 @@ public:
     Q_INVOKABLE void fetchItemDetails(int index);
     Q_INVOKABLE bool hasDetails() { return true; }
 
+    Q_INVOKABLE virtual void download(int index, const QString &path);
+
     KodiModel::ThumbnailFormat thumbnailFormat() const { return KodiModel::ThumbnailFormatPortrait; }
     bool allowWatchedFilter() { return true; }
 
@@ -19,6 +19,8 @@
  ****************************************************************************/
 
 #include "settings.h"
+#include "kodi.h"
+#include "artworkwarmup.h"
 
 #include <QSettings>
 #include <QStringList>
@@ -212,6 +214,34 @@ void Settings::setHapticsEnabled(bool enabled)
     emit hapticsEnabledChanged();
 }
 
+bool Settings::artworkWarmup() const
+{
+    QSettings settings;
+    return settings.value("ArtworkWarmup", true).toBool();
+}
+
+void Settings::setArtworkWarmup(bool artworkWarmup)
+{
+    QSettings settings;
+    settings.setValue("ArtworkWarmup", artworkWarmup);
+    // Each app has its own Settings, tell the one warm-up directly
+    Kodi::instance()->artworkWarmup()->setEnabled(artworkWarmup);
+    emit artworkWarmupChanged();
+}
+
+int Settings::parallelDownloads() const
+{
+    QSettings settings;
+    return settings.value("ParallelDownloads", 2).toInt();
+}
+
+void Settings::setParallelDownloads(int parallelDownloads)
+{
+    QSettings settings;
+    settings.setValue("ParallelDownloads", parallelDownloads);
+    emit parallelDownloadsChanged();
+}
+
 Settings::IntroStep Settings::introStep() const
 {
     QSettings settings;
@@ -42,6 +42,8 @@ class Settings : public QObject
     Q_PROPERTY(bool picturesEnabled READ picturesEnabled WRITE setPicturesEnabled NOTIFY picturesEnabledChanged)
     Q_PROPERTY(bool pvrEnabled READ pvrEnabled WRITE setPvrEnabled NOTIFY pvrEnabledChanged)
     Q_PROPERTY(bool hapticsEnabled READ hapticsEnabled WRITE setHapticsEnabled NOTIFY hapticsEnabledChanged)
+    Q_PROPERTY(bool artworkWarmup READ artworkWarmup WRITE setArtworkWarmup NOTIFY artworkWarmupChanged)
+    Q_PROPERTY(int parallelDownloads READ parallelDownloads WRITE setParallelDownloads NOTIFY parallelDownloadsChanged)
     Q_PROPERTY(IntroStep introStep READ introStep WRITE setIntroStep NOTIFY introStepChanged)
 
 public:
@@ -99,6 +101,12 @@ public:
     bool hapticsEnabled() const;
     void setHapticsEnabled(bool enabled);
 
+    bool artworkWarmup() const;
+    void setArtworkWarmup(bool artworkWarmup);
+
+    int parallelDownloads() const;
+    void setParallelDownloads(int parallelDownloads);
+
     IntroStep introStep() const;
     void setIntroStep(IntroStep introStep);
 
@@ -119,6 +127,8 @@ signals:
     void picturesEnabledChanged();
     void pvrEnabledChanged();
     void hapticsEnabledChanged();
+    void artworkWarmupChanged();
+    void parallelDownloadsChanged();
     void introStepChanged();
 };
 
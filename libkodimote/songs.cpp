@@ -27,12 +27,17 @@
 #include "libraryitem.h"
 #include "kodidownload.h"
 #include "kodebug.h"
+#include "detailscache.h"
 
 Songs::Songs(int artistid, int albumid, KodiModel *parent):
     KodiLibrary(parent),
     m_artistId(artistid),
     m_albumId(albumid)
 {
+    // Recently added/played lists change all the time, don't cache them
+    if (artistid >= ItemIdInvalid && albumid >= ItemIdInvalid) {
+        setCacheKey(cacheKey(artistid, albumid));
+    }
 }
 
 Songs::~Songs()
@@ -44,12 +49,6 @@ void Songs::refresh(int start, int end)
 {
     QVariantMap params;
 
-    if(m_albumId >= 0) {
-        QVariantMap filter;
-        filter.insert("albumid", m_albumId);
-        params.insert("filter", filter);
-    }
-
     QVariantList properties;
     properties.append("artist");
     properties.append("album");
@@ -59,6 +58,23 @@ void Songs::refresh(int start, int end)
 
     params.insert("properties", properties);
 
+    QVariantMap limits;
+    limits.insert("start", start);
+    limits.insert("end", end);
+    params.insert("limits", limits);
+    koDebug(XDAREA_LIBRARY) << "requesting items. From:" << start << "to:" << end;
+
+    sendListCommand(params, "listReceived");
+}
+
+int Songs::sendListCommand(QVariantMap params, const QString &callback)
+{
+    if(m_albumId >= 0) {
+        QVariantMap filter;
+        filter.insert("albumid", m_albumId);
+        params.insert("filter", filter);
+    }
+
     if (m_albumId != KodiModel::ItemIdRecentlyAdded && m_albumId != KodiModel::ItemIdRecentlyPlayed){
         QVariantMap sort;
         if(m_albumId == KodiModel::ItemIdInvalid) {
@@ -70,26 +86,16 @@ void Songs::refresh(int start, int end)
         params.insert("sort", sort);
 }
 
-    QVariantMap limits;
-    limits.insert("start", start);
-    limits.insert("end", end);
-    params.insert("limits", limits);
-    koDebug(XDAREA_LIBRARY) << "requesting items. From:" << start << "to:" << end;
-
     if (m_albumId == KodiModel::ItemIdRecentlyAdded && m_artistId == KodiModel::ItemIdRecentlyAdded) {
-        KodiConnection::sendCommand("AudioLibrary.GetRecentlyAddedSongs", params, this, "listReceived");
+        return KodiConnection::sendCommand("AudioLibrary.GetRecentlyAddedSongs", params, this, callback);
     } else if (m_albumId == KodiModel::ItemIdRecentlyPlayed && m_artistId == KodiModel::ItemIdRecentlyPlayed) {
-        KodiConnection::sendCommand("AudioLibrary.GetRecentlyPlayedSongs", params, this, "listReceived");
-    } else {
-        KodiConnection::sendCommand("AudioLibrary.GetSongs", params, this, "listReceived");
+        return KodiConnection::sendCommand("AudioLibrary.GetRecentlyPlayedSongs", params, this, callback);
     }
+    return KodiConnection::sendCommand("AudioLibrary.GetSongs", params, this, callback);
 }
 
-void Songs::fetchItemDetails(int index)
+QVariantList Songs::detailsProperties()
 {
-    QVariantMap params;
-    params.insert("songid", m_list.at(index)->data(RoleSongId).toInt());
-
     QVariantList properties;
 //    properties.append("title");
 //    properties.append("artist");
@@ -113,12 +119,52 @@ void Songs::fetchItemDetails(int index)
 //    properties.append("artistid");
 //    properties.append("albumid");
 
-    params.insert("properties", properties);
+    return properties;
+}
+
+void Songs::fetchItemDetails(int index)
+{
+    int songId = m_list.at(index)->data(RoleSongId).toInt();
+    if (Kodi::instance()->detailsCache()->contains("song", songId)) {
+        setItemDetails(index, Kodi::instance()->detailsCache()->details("song", songId));
+        return;
+    }
+
+    QVariantMap params;
+    params.insert("songid", songId);
+    params.insert("properties", detailsProperties());
 
     int id = KodiConnection::sendCommand("AudioLibrary.GetSongDetails", params, this, "detailsReceived");
     m_detailsRequestMap.insert(id, index);
 }
 
+void Songs::prefetchItemDetails(int first, int last)
+{
+    first = qMax(0, first);
+    last = qMin(m_list.count() - 1, last);
+
+    // Only ask for the part of the range that isn't cached yet
+    KodiDetailsCache *cache = Kodi::instance()->detailsCache();
+    while (first <= last && cache->contains("song", m_list.at(first)->data(RoleSongId).toInt())) {
+        ++first;
+    }
+    while (last >= first && cache->contains("song", m_list.at(last)->data(RoleSongId).toInt())) {
+        --last;
+    }
+    if (first > last) {
+        return;
+    }
+
+    QVariantMap params;
+    params.insert("properties", detailsProperties());
+    QVariantMap limits;
+    limits.insert("start", first);
+    limits.insert("end", last + 1);
+    params.insert("limits", limits);
+
+    sendListCommand(params, "prefetchReceived");
+}
+
 void Songs::download(int index, const QString &path)
 {
     LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(index));
@@ -183,8 +229,23 @@ void Songs::detailsReceived(const QVariantMap &rsp)
     qDebug() << "got item details:" << rsp;
     int id = rsp.value("id").toInt();
     int row = m_detailsRequestMap.take(id);
-    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(row));
     QVariantMap details = rsp.value("result").toMap().value("songdetails").toMap();
+    Kodi::instance()->detailsCache()->insert("song", details.value("songid").toInt(), details);
+    setItemDetails(row, details);
+}
+
+void Songs::prefetchReceived(const QVariantMap &rsp)
+{
+    QVariantList responseList = rsp.value("result").toMap().value("songs").toList();
+    foreach(const QVariant &itemVariant, responseList) {
+        QVariantMap details = itemVariant.toMap();
+        Kodi::instance()->detailsCache()->insert("song", details.value("songid").toInt(), details);
+    }
+}
+
+void Songs::setItemDetails(int row, const QVariantMap &details)
+{
+    LibraryItem *item = qobject_cast<LibraryItem*>(m_list.at(row));
     item->setYear(details.value("year").toString());
     item->setRating(details.value("rating").toInt());
     item->setDuration(QTime().addSecs(details.value("duration").toInt()));
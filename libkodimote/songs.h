@@ -30,6 +30,7 @@ class Songs : public KodiLibrary
     Q_OBJECT
 public:
     explicit Songs(int artistid = -1, int albumid = -1, KodiModel *parent = 0);
+    static QString cacheKey(int artistId, int albumId) { return QString("Songs/%1/%2").arg(artistId).arg(albumId); }
     ~Songs();
 
     KodiModel* enterItem(int index);
@@ -38,6 +39,7 @@ public:
 
     QString title() const;
     Q_INVOKABLE void fetchItemDetails(int index);
+    Q_INVOKABLE void prefetchItemDetails(int first, int last);
     Q_INVOKABLE bool hasDetails() { return true; }
 
     Q_INVOKABLE void download(int index, const QString &path);
@@ -49,8 +51,13 @@ public slots:
 private slots:
     void listReceived(const QVariantMap &rsp);
     void detailsReceived(const QVariantMap &rsp);
+    void prefetchReceived(const QVariantMap &rsp);
 
 private:
+    int sendListCommand(QVariantMap params, const QString &callback);
+    static QVariantList detailsProperties();
+    void setItemDetails(int row, const QVariantMap &details);
+
     QMap<int, int> m_detailsRequestMap;
 
     int m_artistId;
@@ -0,0 +1,343 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "thumbnailpack.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QDebug>
+
+// Packs smaller than this aren't worth rewriting
+static const qint64 minCompactSize = 4 * 1024 * 1024;
+// Compact once less than this percentage of the pack is in use
+static const int minLivePercentage = 70;
+
+/**
+  * Before there was a pack, the images lived in single files in the same directory.
+  * Nothing reads those anymore. There can be tens of thousands of them, so they are
+  * removed in the background.
+  */
+class StaleFileRemoval : public QRunnable
+{
+public:
+    StaleFileRemoval(const QString &path) : m_path(path) {}
+
+    void run()
+    {
+        QDir dir(m_path);
+        foreach (const QFileInfo &entry, dir.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot)) {
+            if (entry.isDir() && !entry.isSymLink()) {
+                removeTree(entry.absoluteFilePath());
+            } else if (!entry.fileName().startsWith("thumbnails.") && entry.fileName() != "contenthashes") {
+                QFile::remove(entry.absoluteFilePath());
+            }
+        }
+    }
+
+private:
+    static void removeTree(const QString &path)
+    {
+        QDir dir(path);
+        foreach (const QFileInfo &entry, dir.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot)) {
+            if (entry.isDir() && !entry.isSymLink()) {
+                removeTree(entry.absoluteFilePath());
+            } else {
+                QFile::remove(entry.absoluteFilePath());
+            }
+        }
+        dir.rmdir(path);
+    }
+
+    QString m_path;
+};
+
+KodiThumbnailPack::KodiThumbnailPack(const QString &path) :
+    m_path(path),
+    m_liveBytes(0),
+    m_map(0),
+    m_mapSize(0)
+{
+    QDir().mkpath(path);
+    m_packFile.setFileName(path + "/thumbnails.pack");
+    m_indexFile.setFileName(path + "/thumbnails.index");
+    if (!m_indexFile.exists()) {
+        QThreadPool::globalInstance()->start(new StaleFileRemoval(path));
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (open()) {
+        load();
+        compactIfNeeded();
+    }
+}
+
+KodiThumbnailPack::~KodiThumbnailPack()
+{
+    QMutexLocker locker(&m_mutex);
+    close();
+}
+
+bool KodiThumbnailPack::contains(const QString &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(key);
+}
+
+QImage KodiThumbnailPack::image(const QString &key) const
+{
+    QByteArray data;
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QString, Entry>::const_iterator it = m_entries.constFind(key);
+        if (it == m_entries.constEnd()) {
+            return QImage();
+        }
+        // Appended after we last mapped the pack?
+        if (it->offset() + it->length() > m_mapSize && !remap()) {
+            return QImage();
+        }
+        // The mapping may go away with the next compaction. Copy the few KiB
+        // so decoding doesn't hold up everyone else waiting for the lock.
+        data = QByteArray(reinterpret_cast<const char*>(m_map + it->offset()), it->length());
+    }
+    return QImage::fromData(data);
+}
+
+bool KodiThumbnailPack::insert(const QString &key, const QByteArray &data)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_packFile.isOpen() || data.isEmpty()) {
+        return false;
+    }
+
+    qint64 offset = m_packFile.size();
+    if (!m_packFile.seek(offset) || m_packFile.write(data) != data.size() || !m_packFile.flush()) {
+        qDebug() << "cannot write to thumbnail pack" << m_packFile.errorString();
+        m_packFile.resize(offset);
+        return false;
+    }
+
+    Entry entry(offset, data.size());
+    if (!appendIndex(key, entry)) {
+        return false;
+    }
+    addEntry(key, entry);
+
+    compactIfNeeded();
+    return true;
+}
+
+bool KodiThumbnailPack::alias(const QString &key, const QString &existingKey)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_entries.contains(existingKey)) {
+        return false;
+    }
+    Entry entry = m_entries.value(existingKey);
+    if (!appendIndex(key, entry)) {
+        return false;
+    }
+    addEntry(key, entry);
+    return true;
+}
+
+void KodiThumbnailPack::remove(const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_entries.contains(key)) {
+        return;
+    }
+    // A zero length record marks the removal for the next load
+    appendIndex(key, Entry());
+    removeEntry(key);
+
+    compactIfNeeded();
+}
+
+bool KodiThumbnailPack::open()
+{
+    if (!m_packFile.open(QIODevice::ReadWrite) || !m_indexFile.open(QIODevice::ReadWrite)) {
+        qDebug() << "cannot open thumbnail pack in" << m_path;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void KodiThumbnailPack::close()
+{
+    if (m_map) {
+        m_packFile.unmap(m_map);
+        m_map = 0;
+        m_mapSize = 0;
+    }
+    m_packFile.close();
+    m_indexFile.close();
+}
+
+void KodiThumbnailPack::addEntry(const QString &key, const Entry &entry)
+{
+    removeEntry(key);
+    m_entries.insert(key, entry);
+    if (m_references[entry.offset()]++ == 0) {
+        m_liveBytes += entry.length();
+    }
+}
+
+void KodiThumbnailPack::removeEntry(const QString &key)
+{
+    if (!m_entries.contains(key)) {
+        return;
+    }
+    Entry entry = m_entries.take(key);
+    if (--m_references[entry.offset()] == 0) {
+        m_references.remove(entry.offset());
+        m_liveBytes -= entry.length();
+    }
+}
+
+void KodiThumbnailPack::load()
+{
+    m_entries.clear();
+    m_references.clear();
+    m_liveBytes = 0;
+
+    qint64 packSize = m_packFile.size();
+    qint64 validSize = 0;
+    m_indexFile.seek(0);
+    QDataStream stream(&m_indexFile);
+    stream.setVersion(QDataStream::Qt_4_6);
+    while (!stream.atEnd()) {
+        QString key;
+        qint64 offset;
+        qint32 length;
+        stream >> key >> offset >> length;
+        if (stream.status() != QDataStream::Ok || offset < 0 || length < 0 || offset + length > packSize) {
+            // We went down while writing the last record. Drop it.
+            break;
+        }
+        validSize = m_indexFile.pos();
+
+        if (length > 0) {
+            addEntry(key, Entry(offset, length));
+        } else {
+            removeEntry(key);
+        }
+    }
+    if (validSize < m_indexFile.size()) {
+        m_indexFile.resize(validSize);
+    }
+}
+
+bool KodiThumbnailPack::remap() const
+{
+    if (m_map) {
+        m_packFile.unmap(m_map);
+        m_map = 0;
+    }
+    m_mapSize = m_packFile.size();
+    if (m_mapSize > 0) {
+        m_map = m_packFile.map(0, m_mapSize);
+    }
+    if (!m_map) {
+        m_mapSize = 0;
+        return false;
+    }
+    return true;
+}
+
+bool KodiThumbnailPack::appendIndex(const QString &key, const Entry &entry)
+{
+    m_indexFile.seek(m_indexFile.size());
+    QDataStream stream(&m_indexFile);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << key << entry.offset() << entry.length();
+    if (stream.status() != QDataStream::Ok || !m_indexFile.flush()) {
+        qDebug() << "cannot write thumbnail pack index" << m_indexFile.errorString();
+        return false;
+    }
+    return true;
+}
+
+void KodiThumbnailPack::compactIfNeeded()
+{
+    qint64 packSize = m_packFile.size();
+    if (packSize < minCompactSize || m_liveBytes * 100 >= packSize * minLivePercentage) {
+        return;
+    }
+    if (m_mapSize < packSize && !remap()) {
+        return;
+    }
+
+    qDebug() << "compacting thumbnail pack:" << m_liveBytes << "of" << packSize << "bytes in use";
+
+    // Copy everything that's still in use to fresh files and swap them in
+    QFile newPackFile(m_packFile.fileName() + ".new");
+    QFile newIndexFile(m_indexFile.fileName() + ".new");
+    if (!newPackFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || !newIndexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return;
+    }
+
+    QHash<QString, Entry> entries;
+    QHash<qint64, qint64> newOffsets; // Aliases are copied only once
+    qint64 offset = 0;
+    QDataStream stream(&newIndexFile);
+    stream.setVersion(QDataStream::Qt_4_6);
+    QHash<QString, Entry>::const_iterator it = m_entries.constBegin();
+    for (; it != m_entries.constEnd(); ++it) {
+        if (!newOffsets.contains(it->offset())) {
+            if (newPackFile.write(reinterpret_cast<const char*>(m_map + it->offset()), it->length()) != it->length()) {
+                break;
+            }
+            newOffsets.insert(it->offset(), offset);
+            offset += it->length();
+        }
+        Entry entry(newOffsets.value(it->offset()), it->length());
+        stream << it.key() << entry.offset() << entry.length();
+        entries.insert(it.key(), entry);
+    }
+    newPackFile.close();
+    newIndexFile.close();
+    if (it != m_entries.constEnd() || stream.status() != QDataStream::Ok) {
+        qDebug() << "compacting thumbnail pack failed";
+        newPackFile.remove();
+        newIndexFile.remove();
+        return;
+    }
+
+    // Index goes first. Losing it just means an empty cache, a stale one would point into the wrong data.
+    close();
+    QFile::remove(m_indexFile.fileName());
+    QFile::remove(m_packFile.fileName());
+    newPackFile.rename(m_packFile.fileName());
+    newIndexFile.rename(m_indexFile.fileName());
+
+    m_entries.clear();
+    m_references.clear();
+    m_liveBytes = 0;
+    if (open()) {
+        QHash<QString, Entry>::const_iterator entry = entries.constBegin();
+        for (; entry != entries.constEnd(); ++entry) {
+            addEntry(entry.key(), entry.value());
+        }
+    }
+}
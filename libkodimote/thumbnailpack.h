@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef THUMBNAILPACK_H
+#define THUMBNAILPACK_H
+
+#include <QString>
+#include <QHash>
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+
+/**
+  * Append-only store for lots of small images
+  * All images live in one pack file, memory mapped for reading. A separate index file
+  * records where each of them is. Replaced or removed images leave holes which are
+  * compacted away once they make up a considerable part of the pack.
+  * All methods are thread safe.
+  */
+class KodiThumbnailPack
+{
+public:
+    explicit KodiThumbnailPack(const QString &path);
+    ~KodiThumbnailPack();
+
+    bool contains(const QString &key) const;
+    QImage image(const QString &key) const;
+
+    bool insert(const QString &key, const QByteArray &data);
+    // Makes "key" refer to the same data as "existingKey" without storing it again
+    bool alias(const QString &key, const QString &existingKey);
+    void remove(const QString &key);
+
+private:
+    class Entry
+    {
+    public:
+        Entry(qint64 offset = 0, qint32 length = 0) : m_offset(offset), m_length(length) {}
+        qint64 offset() const { return m_offset; }
+        qint32 length() const { return m_length; }
+    private:
+        qint64 m_offset;
+        qint32 m_length;
+    };
+
+    bool open();
+    void close();
+    void load();
+    bool remap() const;
+    bool appendIndex(const QString &key, const Entry &entry);
+    void addEntry(const QString &key, const Entry &entry);
+    void removeEntry(const QString &key);
+    void compactIfNeeded();
+
+    QString m_path;
+    QHash<QString, Entry> m_entries;
+    QHash<qint64, int> m_references; // offset -> number of keys using it
+    qint64 m_liveBytes;
+
+    mutable QFile m_packFile;
+    QFile m_indexFile;
+    mutable uchar *m_map;
+    mutable qint64 m_mapSize;
+
+    mutable QMutex m_mutex;
+};
+
+#endif // THUMBNAILPACK_H
@@ -31,6 +31,7 @@ TvShows::TvShows(KodiModel *parent) :
     KodiLibrary(parent),
     m_refreshing(false)
 {
+    setCacheKey(cacheKey());
     connect(KodiConnection::notifier(), SIGNAL(receivedAnnouncement(QVariantMap)), SLOT(receivedAnnouncement(QVariantMap)));
 }
 
@@ -182,7 +183,12 @@ void TvShows::showDetailsReceived(const QVariantMap &rsp)
 
 KodiModel *TvShows::enterItem(int index)
 {
-    return new Seasons(m_list.at(index)->data(RoleTvShowId).toInt(), this);
+    int tvshowId = m_list.at(index)->data(RoleTvShowId).toInt();
+    KodiModel *model = cachedModel(Seasons::cacheKey(tvshowId));
+    if (!model) {
+        model = new Seasons(tvshowId, this);
+    }
+    return model;
 }
 
 void TvShows::playItem(int index)
@@ -30,6 +30,7 @@ class TvShows : public KodiLibrary
     Q_OBJECT
 public:
     explicit TvShows(KodiModel *parent = 0);
+    static QString cacheKey() { return QString("TvShows"); }
     ~TvShows();
 
     KodiModel *enterItem(int index);
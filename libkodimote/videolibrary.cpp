@@ -66,12 +66,18 @@ VideoLibrary::VideoLibrary(KodiModel *parent) :
 KodiModel *VideoLibrary::enterItem(int index)
 {
     switch(index) {
-    case 0:
-        return new Movies(false, this);
-    case 1:
-        return new TvShows(this);
-    case 2:
-        return new MusicVideos(false, this);
+    case 0: {
+        KodiModel *model = cachedModel(Movies::cacheKey());
+        return model ? model : new Movies(false, this);
+    }
+    case 1: {
+        KodiModel *model = cachedModel(TvShows::cacheKey());
+        return model ? model : new TvShows(this);
+    }
+    case 2: {
+        KodiModel *model = cachedModel(MusicVideos::cacheKey());
+        return model ? model : new MusicVideos(false, this);
+    }
     case 3:
         return new RecentItems(RecentItems::ModeVideo, RecentItems::RecentlyAdded, this);
     case 4:
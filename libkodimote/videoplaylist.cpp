@@ -32,16 +32,69 @@ int VideoPlaylist::playlistId() const
     return 1;
 }
 
-void VideoPlaylist::refresh()
+QVariantList VideoPlaylist::itemProperties() const
 {
-    QVariantMap params;
     QVariantList properties;
     properties.append("title");
     properties.append("runtime");
-    params.insert("properties", properties);
-    params.insert("playlistid", playlistId());
+    return properties;
+}
+
+void VideoPlaylist::insertItems(int position, int count)
+{
+    beginInsertRows(QModelIndex(), position, position + count - 1);
+    for(int i = 0; i < count; ++i) {
+        m_itemList.insert(position, 0);
+    }
+    endInsertRows();
+}
+
+void VideoPlaylist::removeItems(int position, int count)
+{
+    beginRemoveRows(QModelIndex(), position, position + count - 1);
+    for(int i = 0; i < count; ++i) {
+        delete m_itemList.takeAt(position);
+    }
+    endRemoveRows();
+}
+
+void VideoPlaylist::clearItems()
+{
+    beginResetModel();
+    qDeleteAll(m_itemList);
+    m_itemList.clear();
+    endResetModel();
+}
+
+void VideoPlaylist::setItemData(int position, const QVariantList &items)
+{
+    int end = qMin(position + items.count(), m_itemList.count());
+    for(int i = position; i < end; ++i) {
+        if(!m_itemList.at(i)) {
+            m_itemList[i] = new VideoPlaylistItem();
+        }
+        fillItem(m_itemList.at(i), items.at(i - position).toMap());
+    }
+    if(end > position) {
+        emit dataChanged(index(position, 0, QModelIndex()), index(end - 1, 0, QModelIndex()));
+    }
+}
+
+void VideoPlaylist::releaseItems(int start, int end)
+{
+    for(int i = start; i < end; ++i) {
+        delete m_itemList.at(i);
+        m_itemList[i] = 0;
+    }
+    if(end > start) {
+        emit dataChanged(index(start, 0, QModelIndex()), index(end - 1, 0, QModelIndex()));
+    }
+}
 
-    KodiConnection::sendCommand("Playlist.GetItems", params, this, "itemsReceived");
+void VideoPlaylist::fillItem(VideoPlaylistItem *item, const QVariantMap &itemMap)
+{
+    item->setLabel(itemMap.value("label").toString());
+    item->setDuration(QTime(0, 0, 0).addSecs(itemMap.value("runtime").toDouble()));
 }
 
 void VideoPlaylist::queryItemData(int index)
@@ -68,69 +121,47 @@ void VideoPlaylist::queryItemData(int index)
     KodiConnection::sendCommand("Playlist.GetItems", params, this, "currentDataReceived");
 }
 
-void VideoPlaylist::itemsReceived(const QVariantMap &rsp)
+void VideoPlaylist::currentDataReceived(const QVariantMap &rsp)
 {
-    koDebug(XDAREA_PLAYLIST) << "VideoPlaylist response:" << rsp;
-    if(rsp.contains("error")) {
-        koDebug(XDAREA_PLAYLIST) << "Failed to fetch itemdata";
-        return;
-    }
-
-    QVariant result = rsp.value("result");
-
-//    koDebug(XDAREA_PLAYLIST) << "got GetItems response:" << response;
-//    koDebug(XDAREA_PLAYLIST) << "resetting model";
     QVariantList responseList = rsp.value("result").toMap().value("items").toList();
-    bool modelResetted = false;
-    if(responseList.count() != m_itemList.count()) {
-        beginResetModel();
-        modelResetted = true;
-    }
-    while(!m_itemList.isEmpty()){
-        delete m_itemList.takeFirst();
-    }
-    foreach(const QVariant &itemVariant, responseList) {
-        QVariantMap itemMap = itemVariant.toMap();
-        VideoPlaylistItem *item = new VideoPlaylistItem();
-        item->setLabel(itemMap.value("label").toString());
-        item->setDuration(QTime(0, 0, 0).addSecs(itemMap.value("runtime").toDouble()));
-//        item.setTitle(itemMap.value("title").toString());
-//        item.setArtist(itemMap.value("artist").toString());
-        koDebug(XDAREA_PLAYLIST) << "adding item:" << item->label() << item->fanart();
-        m_itemList.append(item);
-    }
-    if(modelResetted) {
-        endResetModel();
-    } else {
-        emit dataChanged(index(0, 0, QModelIndex()), index(m_itemList.count() - 1, 0, QModelIndex()));
+    if(m_itemList.count() > m_currentItem && m_currentItem > -1 && !responseList.isEmpty()) {
+        if(!m_itemList.at(m_currentItem)) {
+            m_itemList[m_currentItem] = new VideoPlaylistItem();
+        }
+        if(!m_current) {
+            m_current = new VideoPlaylistItem();
+            m_current->setParent(this);
+        }
+        QVariantMap itemMap = responseList.first().toMap();
+        fillDetails(m_itemList.at(m_currentItem), itemMap);
+        fillDetails(static_cast<VideoPlaylistItem*>(m_current), itemMap);
+        m_currentRow = m_currentItem;
+        emit currentChanged();
     }
-    emit countChanged();
 }
 
-void VideoPlaylist::currentDataReceived(const QVariantMap &rsp)
+void VideoPlaylist::fillDetails(VideoPlaylistItem *item, const QVariantMap &itemMap)
 {
-    if(m_itemList.count() > m_currentItem && m_currentItem > -1) {
-        VideoPlaylistItem *item = m_itemList.at(m_currentItem);
-        QVariantList responseList = rsp.value("result").toMap().value("items").toList();
-        QVariantMap itemMap = responseList.first().toMap();
-//        item.setFanart(itemMap.value("fanart").toString());
-        item->setDuration(QTime(0, 0, 0).addSecs(itemMap.value("runtime").toDouble()));
-        item->setLabel(itemMap.value("label").toString());
-        item->setFile(itemMap.value("file").toString());
-        item->setTitle(itemMap.value("title").toString());
-        item->setType(itemMap.value("type").toString());
-        item->setTvShow(itemMap.value("showtitle").toString());
-        item->setSeason(itemMap.value("season").toString());
-        item->setFanart(itemMap.value("fanart").toString());
-        item->setThumbnail(itemMap.value("thumbnail").toString());
-        item->setYear(itemMap.value("year").toString());
-        item->setRating(itemMap.value("rating").toString());
-        emit currentChanged();
-    }
+    item->setDuration(QTime(0, 0, 0).addSecs(itemMap.value("runtime").toDouble()));
+    item->setLabel(itemMap.value("label").toString());
+    item->setFile(itemMap.value("file").toString());
+    item->setTitle(itemMap.value("title").toString());
+    item->setType(itemMap.value("type").toString());
+    item->setTvShow(itemMap.value("showtitle").toString());
+    item->setSeason(itemMap.value("season").toString());
+    item->setFanart(itemMap.value("fanart").toString());
+    item->setThumbnail(itemMap.value("thumbnail").toString());
+    item->setYear(itemMap.value("year").toString());
+    item->setRating(itemMap.value("rating").toString());
 }
 
 QVariant VideoPlaylist::data(const QModelIndex &index, int role) const
 {
+    if(!m_itemList.at(index.row())) {
+        requestItem(index.row());
+        return role == RoleFileType ? QVariant("file") : QVariant();
+    }
+
     switch(role) {
     case RoleTitle:
         return m_itemList.at(index.row())->label();
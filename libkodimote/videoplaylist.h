@@ -39,17 +39,23 @@ public:
     QString title() const;
     int playlistId() const;
 
-public slots:
-    void refresh();
-
 protected:
     void queryItemData(int index);
 
+    QVariantList itemProperties() const;
+    void insertItems(int position, int count);
+    void removeItems(int position, int count);
+    void clearItems();
+    void setItemData(int position, const QVariantList &items);
+    void releaseItems(int start, int end);
+
 private slots:
-    void itemsReceived(const QVariantMap &rsp);
     void currentDataReceived(const QVariantMap &rsp);
 
 private:
+    static void fillItem(VideoPlaylistItem *item, const QVariantMap &itemMap);
+    static void fillDetails(VideoPlaylistItem *item, const QVariantMap &itemMap);
+
     QList<VideoPlaylistItem*> m_itemList;
 };
 
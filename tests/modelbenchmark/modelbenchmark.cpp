@@ -0,0 +1,76 @@
+/*****************************************************************************
+ * Copyright: 2011-2013 Michael Zanetti <michael_zanetti@gmx.net>            *
+ *                                                                           *
+ * This file is part of Kodimote                                           *
+ *                                                                           *
+ * Kodimote is free software: you can redistribute it and/or modify        *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * Kodimote is distributed in the hope that it will be useful,             *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *                                                                           *
+ ****************************************************************************/
+
+#include "libkodimote/kodimodel.h"
+#include "libkodimote/libraryitem.h"
+
+#include <QtTest>
+
+/**
+  * Measures filling a model with a large number of items and tearing it down
+  * again, like entering and leaving a big song list.
+  */
+class BenchmarkModel : public KodiModel
+{
+public:
+    BenchmarkModel(int count)
+    {
+        for(int i = 0; i < count; ++i) {
+            m_list.append(new LibraryItem(QString::number(i), QString(), this));
+        }
+    }
+
+    QString title() const { return "Benchmark"; }
+    void refresh() {}
+};
+
+class ModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void createDestroy_data();
+    void createDestroy();
+};
+
+void ModelBenchmark::createDestroy_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("50k") << 50000;
+}
+
+void ModelBenchmark::createDestroy()
+{
+    QFETCH(int, count);
+
+    QBENCHMARK {
+        BenchmarkModel *model = new BenchmarkModel(count);
+        QCOMPARE(model->rowCount(), count);
+        delete model;
+        // Nothing may be left for the event loop to clean up
+        QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+    }
+}
+
+QTEST_MAIN(ModelBenchmark)
+
+#include "modelbenchmark.moc"
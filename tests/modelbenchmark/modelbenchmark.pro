@@ -0,0 +1,14 @@
+include(../../config.pri)
+
+TARGET = modelbenchmark
+QT += testlib network
+
+# libkodimote is linked statically, pull in everything it uses
+contains(QT_VERSION, ^5\\..\\..*) {
+    DEFINES += QT5_BUILD
+    QT += gui quick qml
+} else {
+    QT += gui declarative
+}
+
+SOURCES += modelbenchmark.cpp